@@ -0,0 +1,50 @@
+// Measures how many times a second MoveGenerator can find every placement for
+// a shape, on a board with some stack to move around
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include "../lib/movegen.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr int CALLS = 200'000;
+
+// A 10x40 board with its bottom eight rows filled in, bar a hole in each, and
+// a few cells sticking up out of them to make overhangs
+Board partlyFilled() {
+  Board board{10, 40};
+  Xoshiro256 rng{3};
+  for (int y = 0; y < 8; y++) {
+    auto hole = (int)rng.below(10);
+    for (int x = 0; x < 10; x++) {
+      board.setCellAt(x, y, x != hole);
+    }
+  }
+  for (int x : {1, 2, 6, 9}) {
+    board.setCellAt(x, 9, true);
+  }
+  return board;
+}
+} // namespace
+
+int main() {
+  auto generator = std::make_unique<MoveGenerator>();
+  auto board = partlyFilled();
+
+  for (auto [name, shape] : {std::pair{"T", &StandardShapeFactory::T_BLOCK},
+                             std::pair{"I", &StandardShapeFactory::I_BLOCK}}) {
+    auto spawn = spawnLocation(board, *shape);
+    std::size_t placements = 0;
+    auto start = Clock::now();
+    for (int call = 0; call < CALLS; call++) {
+      placements += generator->generate(board, *shape, spawn).size();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::printf("%s: %zu placements a call, %d calls in %.3fs: %.0f calls/s\n",
+                name, placements / CALLS, CALLS, elapsed.count(),
+                CALLS / elapsed.count());
+  }
+  return 0;
+}
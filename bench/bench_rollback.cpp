@@ -0,0 +1,78 @@
+// Measures how fast Rollback can rewind and play frames again -- which bounds
+// how far behind remote inputs can be before a rollback drops a frame
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "../lib/rollback.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr std::size_t HISTORY = 64;
+
+// Between none and two inputs a frame, with a drop every so often
+std::vector<std::vector<Input>> frameInputs(int frames) {
+  std::vector<std::vector<Input>> result(frames);
+  Xoshiro256 rng{17};
+  for (auto &inputs : result) {
+    switch (rng.below(8)) {
+    case 0:
+      inputs.push_back(Direction::LEFT);
+      break;
+    case 1:
+      inputs.push_back(Direction::RIGHT);
+      break;
+    case 2:
+      inputs.push_back(Rotation::CLOCKWISE);
+      inputs.push_back(Direction::LEFT);
+      break;
+    case 3:
+      inputs.push_back(Key::SPACE);
+      break;
+    case 4:
+      inputs.push_back(Direction::DOWN);
+      break;
+    default:
+      break;
+    }
+  }
+  return result;
+}
+} // namespace
+
+int main() {
+  using Game = Rollback<BagShapeFactory, HISTORY>;
+  auto inputs = frameInputs(100'000);
+  auto rollback = std::make_unique<Game>(TetrisFactory::seededTetris(1));
+
+  // Every frame, the inputs from HISTORY - 1 frames ago turn out to have been
+  // a move to the left rather than what was guessed, so every frame rewinds as
+  // far as it can
+  const std::vector<Input> late{Direction::LEFT};
+  long resimulated = 0;
+  long rollbacks = 0;
+  auto start = Clock::now();
+  for (auto &frame : inputs) {
+    if (rollback->getTetris().isToppedOut()) {
+      rollback = std::make_unique<Game>(TetrisFactory::seededTetris(1));
+    }
+    (void)rollback->advance(frame);
+    if (rollback->frame() >= (int)HISTORY) {
+      auto replayed =
+          rollback->correct(rollback->oldestFrame(), late).value_or(0);
+      resimulated += replayed;
+      rollbacks += replayed > 0;
+    }
+  }
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  std::printf("%zu frames of history, %zu frames played\n", HISTORY,
+              inputs.size());
+  std::printf("%ld rollbacks resimulated %ld frames in %.3fs: %.0f frames/s, "
+              "%.2fus per rollback\n",
+              rollbacks, resimulated, elapsed.count(),
+              resimulated / elapsed.count(),
+              elapsed.count() * 1e6 / (double)rollbacks);
+  return 0;
+}
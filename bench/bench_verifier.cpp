@@ -0,0 +1,43 @@
+// Measures how many recorded games verifyArchive can check a second, across
+// every core
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../fixtures/replay_fixtures.hpp"
+#include "../lib/verifier.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr int GAMES = 4000;
+// About a minute and a half of play at 60 frames a second
+constexpr int EVENTS = 2000;
+} // namespace
+
+int main() {
+  auto path =
+      (std::filesystem::temp_directory_path() / "bench_verifier.tarc").string();
+  {
+    std::ofstream out{path, std::ios::binary};
+    ArchiveWriter<BagShapeFactory> writer{out};
+    for (std::uint64_t seed = 1; seed <= GAMES; seed++) {
+      (void)writer.addGame(recordGame(seed, EVENTS));
+    }
+  }
+
+  auto archive = ReplayArchive<BagShapeFactory>::open(path).value();
+  WorkStealingPool pool;
+  auto start = Clock::now();
+  auto report = verifyArchive(pool, archive);
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  std::filesystem::remove(path);
+
+  std::printf("%zu games of %d events on %u threads, %zu mismatched\n",
+              report.verified, EVENTS, pool.size(), report.mismatches.size());
+  std::printf("verified in %.3fs: %.0f games/s\n", elapsed.count(),
+              (double)report.verified / elapsed.count());
+  return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../lib/replay.hpp"
+
+// Recorded games to archive and verify, shared by the tests and benchmarks --
+// kept out of test/ so the benchmarks only depend on the library and these
+
+// A recorded game of random inputs, a frame or few apart
+inline std::vector<std::uint8_t> recordGame(std::uint64_t seed, int events) {
+  std::ostringstream out;
+  {
+    ReplayWriter writer{out, {.seed = seed}};
+    Xoshiro256 rng{seed};
+    std::uint64_t frame = 0;
+    for (int i = 0; i < events; i++) {
+      frame += rng.below(4);
+      writer.record(frame, *ReplayFormat::codeInput(rng.below(7)));
+    }
+  }
+  auto string = out.str();
+  return {string.begin(), string.end()};
+}
+
+// A file in the temporary directory, removed again when done with
+struct TempFile {
+  std::string path;
+  explicit TempFile(const std::string &name)
+      : path((std::filesystem::temp_directory_path() / name).string()) {}
+  ~TempFile() { std::filesystem::remove(path); }
+};
@@ -0,0 +1,603 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "replay.hpp"
+
+// An archive holds many recorded games in one file:
+//
+//   header | replay, keyframes | replay, keyframes | ... | index | footer
+//
+// Each game's replay is stored as written by ReplayWriter. After it come
+// keyframes: snapshots of the game every so many events, so that any frame can
+// be reached by restoring the keyframe before it and replaying from there. The
+// index at the end says where each game's replay and keyframes are, and the
+// footer says where the index is
+//
+// Keyframes are raw GameStates, so an archive can only be read by a build with
+// the same shape factory and GameState layout. They're written without any
+// padding or unused storage, so the same games always make the same file
+
+// How a recorded game ended up
+struct ArchivedResult {
+  std::uint64_t hash{0};
+  std::uint64_t events{0};
+  std::uint64_t lastFrame{0};
+  std::int32_t score{0};
+  std::int32_t lines{0};
+  std::int32_t pieces{0};
+  std::int32_t toppedOut{0};
+
+  bool operator==(const ArchivedResult &other) const = default;
+};
+
+// A recorded game in an archive
+struct ArchivedGame {
+  ReplayHeader header;
+  // The game's replay, as written by ReplayWriter
+  std::span<const std::uint8_t> replay;
+  // How the game ended up, as claimed when it was added
+  ArchivedResult result;
+};
+
+// A snapshot of a recorded game, after its first `events` events
+template <ShapeFactory Factory> struct ArchivedKeyframe {
+  std::uint64_t events;
+  std::uint64_t frame;
+  GameState<Factory> state;
+};
+
+enum class ArchiveError {
+  CANT_OPEN,
+  BAD_FORMAT,
+  // The archive's keyframes are from a build with a different GameState
+  WRONG_STATE_SIZE,
+  BAD_REPLAY,
+  // The replay's header doesn't describe a game that can be created
+  BAD_GAME,
+};
+
+namespace archive_detail {
+constexpr std::array<std::uint8_t, 4> MAGIC{'T', 'A', 'R', 'C'};
+constexpr std::uint32_t VERSION = 1;
+
+struct FileHeader {
+  std::array<std::uint8_t, 4> magic;
+  std::uint32_t version;
+  std::uint64_t stateSize;
+};
+
+struct Footer {
+  std::uint64_t indexOffset;
+  std::uint64_t games;
+  std::array<std::uint8_t, 4> magic;
+  std::uint32_t version;
+};
+
+struct IndexEntry {
+  std::uint64_t replayOffset;
+  std::uint64_t replaySize;
+  std::uint64_t keyframesOffset;
+  std::uint64_t keyframeCount;
+  ArchivedResult result;
+};
+
+// Shapes in a snapshot point at their kick tables, which won't be at the same
+// address in another process, so keyframes store which of the factory's kick
+// tables each shape uses instead
+// Those are the shape in play, the held shape and the upcoming shapes
+constexpr int KEYFRAME_SHAPES = 2 + 32;
+
+template <ShapeFactory Factory> struct Keyframe {
+  // Where the replay's reader was up to, after `events` events
+  std::uint64_t position;
+  std::uint64_t frame;
+  std::uint64_t events;
+  std::array<std::uint8_t, KEYFRAME_SHAPES> kickTables;
+  GameState<Factory> state;
+};
+
+// Copies `state` into `out`, which must have started out zeroed, so that the
+// same game always writes the same bytes: only members are copied, never the
+// padding between them, and neither are the slots of the upcoming shapes that
+// aren't in use, nor the held shape when there isn't one
+// Every member of GameState has to be copied here
+template <ShapeFactory Factory>
+void canonicalise(const GameState<Factory> &state, GameState<Factory> &out) {
+  static_assert(std::has_unique_object_representations_v<Shape>);
+  static_assert(std::is_empty_v<Factory> or
+                    std::has_unique_object_representations_v<Factory>,
+                "keyframes are written byte for byte, so the shape factory "
+                "can't have padding");
+
+  state.board.copyMembersTo(out.board);
+  if constexpr (not std::is_empty_v<Factory>) {
+    out.factory = state.factory;
+  }
+  // Starting from the front of the buffer
+  for (int i = 0; i < (int)state.upcoming.size(); i++) {
+    out.upcoming.push_back(state.upcoming[i]);
+  }
+  out.previewSize = state.previewSize;
+  out.currentShape = state.currentShape;
+  out.shapeLocation = state.shapeLocation;
+  if (state.holdShape) {
+    out.holdShape.emplace(*state.holdShape);
+  }
+  out.heldInTurn = state.heldInTurn;
+  out.level = state.level;
+  out.score = state.score;
+  out.chain.combo = state.chain.combo;
+  out.chain.backToBack = state.chain.backToBack;
+  out.lastLock.lines = state.lastLock.lines;
+  out.lastLock.spin = state.lastLock.spin;
+  out.rotatedLast = state.rotatedLast;
+  out.kickedLast = state.kickedLast;
+  out.pieces = state.pieces;
+  out.lines = state.lines;
+  out.status = state.status;
+  out.stateHash = state.stateHash;
+}
+
+template <ShapeFactory Factory> class KickTables {
+  static_assert(2 + decltype(GameState<Factory>::upcoming)::capacity() ==
+                KEYFRAME_SHAPES);
+
+private:
+  std::vector<const Shape::KickData *> tables{nullptr};
+
+  template <typename F>
+  static void forShapes(GameState<Factory> &state, F f) {
+    f(0, state.currentShape);
+    if (state.holdShape) {
+      f(1, *state.holdShape);
+    }
+    for (int i = 0; i < (int)state.upcoming.size(); i++) {
+      f(2 + i, state.upcoming[i]);
+    }
+  }
+
+public:
+  explicit KickTables(const Factory &factory) {
+    for (auto &shape : factory.getShapes()) {
+      if (std::ranges::find(tables, shape.kickData) == tables.end()) {
+        tables.push_back(shape.kickData);
+      }
+    }
+  }
+
+  // Swaps the kick table pointers in `state` for indices in `out`
+  void encode(GameState<Factory> &state,
+              std::array<std::uint8_t, KEYFRAME_SHAPES> &out) const {
+    out.fill(0);
+    forShapes(state, [&](int i, Shape &shape) {
+      auto found = std::ranges::find(tables, shape.kickData);
+      out[i] = found == tables.end() ? 0
+                                     : (std::uint8_t)(found - tables.begin());
+      shape.kickData = nullptr;
+    });
+  }
+
+  // Swaps the indices in `in` back for kick table pointers in `state`
+  // Returns false if any of them aren't one of the factory's tables
+  bool decode(GameState<Factory> &state,
+              const std::array<std::uint8_t, KEYFRAME_SHAPES> &in) const {
+    bool known = true;
+    forShapes(state, [&](int i, Shape &shape) {
+      known = known and in[i] < tables.size();
+      shape.kickData = in[i] < tables.size() ? tables[in[i]] : nullptr;
+    });
+    return known;
+  }
+};
+
+// Whether a keyframe's state could have come from playing a `width` by
+// `height` game, so that it's safe to restore: nothing in it indexes out of
+// bounds, and the shape in play doesn't overlap the stack
+template <ShapeFactory Factory>
+bool validState(const GameState<Factory> &state, int width, int height) {
+  auto validShape = [](const Shape &shape) {
+    return shape.size >= 1 and shape.size <= PIECE_MASK_SIZE and
+           shape.rotationIndex >= 0 and shape.rotationIndex < 4;
+  };
+  auto &board = state.board;
+  auto location = state.shapeLocation;
+  if (not board.consistent() or board.getWidth() != width or
+      board.getHeight() != height or not state.upcoming.consistent() or
+      state.previewSize < 1 or
+      state.previewSize > Tetris<Factory>::MAX_PREVIEW or
+      state.status > GameStatus::LOCKED_OUT or
+      state.lastLock.spin > Spin::FULL or location.x < -PIECE_MASK_SIZE or
+      location.x > width or location.y < -PIECE_MASK_SIZE or
+      location.y > height) {
+    return false;
+  }
+  if (not validShape(state.currentShape) or
+      (state.holdShape and not validShape(*state.holdShape))) {
+    return false;
+  }
+  for (int i = 0; i < (int)state.upcoming.size(); i++) {
+    if (not validShape(state.upcoming[i])) {
+      return false;
+    }
+  }
+  return state.status != GameStatus::PLAYING or
+         not board.collides(state.currentShape.mask(), location.x,
+                            location.y);
+}
+
+template <typename T> T load(std::span<const std::uint8_t> bytes) {
+  T value;
+  std::memcpy((void *)&value, bytes.data(), sizeof(T));
+  return value;
+}
+} // namespace archive_detail
+
+// Writes games into an archive one at a time, straight out to the stream --
+// only the index is kept until the end
+template <ShapeFactory Factory>
+  requires std::constructible_from<Factory, std::uint64_t>
+class ArchiveWriter {
+private:
+  using Keyframe = archive_detail::Keyframe<Factory>;
+
+  std::ostream &out;
+  int keyframeInterval;
+  std::uint64_t offset{0};
+  std::vector<archive_detail::IndexEntry> index;
+  bool finished = false;
+  // Every seed deals from the same shapes, so one set of kick tables does for
+  // every game
+  archive_detail::KickTables<Factory> kickTables{Factory{0}};
+
+  template <typename T> void write(const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    offset += sizeof(T);
+  }
+
+public:
+  // Keyframes are taken every `_keyframeInterval` events, which must be at
+  // least 1
+  explicit ArchiveWriter(std::ostream &_out, int _keyframeInterval = 256)
+      : out(_out), keyframeInterval(_keyframeInterval) {
+    if (_keyframeInterval < 1) {
+      throw std::invalid_argument(std::format(
+          "keyframe interval {} is too small (must be at least 1)",
+          _keyframeInterval));
+    }
+    write(archive_detail::FileHeader{archive_detail::MAGIC,
+                                     archive_detail::VERSION,
+                                     sizeof(GameState<Factory>)});
+  }
+
+  ArchiveWriter(const ArchiveWriter &) = delete;
+  ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+
+  ~ArchiveWriter() { finish(); }
+
+private:
+  std::expected<ArchivedResult, ArchiveError>
+  add(std::span<const std::uint8_t> replay,
+      const std::optional<ArchivedResult> &claimed) {
+    auto reader = ReplayReader::open(replay);
+    if (not reader) {
+      return std::unexpected(ArchiveError::BAD_REPLAY);
+    }
+    auto tetris = startReplay<Factory>(reader->getHeader());
+    if (not tetris) {
+      return std::unexpected(ArchiveError::BAD_GAME);
+    }
+
+    // Keyframes are only written once the whole replay is known to be good
+    std::vector<Keyframe> keyframes;
+    std::uint64_t events = 0;
+    while (true) {
+      auto event = reader->next();
+      if (not event) {
+        return std::unexpected(ArchiveError::BAD_REPLAY);
+      } else if (not *event) {
+        break;
+      }
+      tetris->handleInput((*event)->input);
+      events++;
+
+      if (events % keyframeInterval == 0) {
+        Keyframe keyframe;
+        std::memset((void *)&keyframe, 0, sizeof(keyframe));
+        keyframe.position = reader->position();
+        keyframe.frame = reader->getFrame();
+        keyframe.events = events;
+        archive_detail::canonicalise(tetris->snapshot(), keyframe.state);
+        kickTables.encode(keyframe.state, keyframe.kickTables);
+        keyframes.push_back(keyframe);
+      }
+    }
+
+    ArchivedResult result{tetris->hash(),
+                          events,
+                          reader->getFrame(),
+                          tetris->getScore(),
+                          tetris->getLines(),
+                          tetris->getPieces(),
+                          tetris->isToppedOut()};
+
+    archive_detail::IndexEntry entry{offset, reader->position(), 0,
+                                     keyframes.size(),
+                                     claimed.value_or(result)};
+    out.write(reinterpret_cast<const char *>(replay.data()),
+              (std::streamsize)reader->position());
+    offset += reader->position();
+    entry.keyframesOffset = offset;
+    for (auto &keyframe : keyframes) {
+      write(keyframe);
+    }
+    index.push_back(entry);
+    return result;
+  }
+
+public:
+  // Adds the replay at the start of `replay`, playing it through to take its
+  // keyframes, and returns how the game ended up
+  std::expected<ArchivedResult, ArchiveError>
+  addGame(std::span<const std::uint8_t> replay) {
+    return add(replay, std::nullopt);
+  }
+
+  // Adds a replay like addGame, but records `claimed` as how the game ended
+  // up, for it to be checked later by verifyArchive
+  std::expected<ArchivedResult, ArchiveError>
+  addGame(std::span<const std::uint8_t> replay,
+          const ArchivedResult &claimed) {
+    return add(replay, claimed);
+  }
+
+  // Writes out the index -- nothing can be added after
+  void finish() {
+    if (finished) {
+      return;
+    }
+    finished = true;
+    auto indexOffset = offset;
+    for (auto &entry : index) {
+      write(entry);
+    }
+    write(archive_detail::Footer{indexOffset, index.size(),
+                                 archive_detail::MAGIC,
+                                 archive_detail::VERSION});
+    out.flush();
+  }
+};
+
+// A read-only view of an archive file, mapped into memory so that reading it
+// doesn't copy it
+class MappedFile {
+private:
+  const std::uint8_t *data{nullptr};
+  std::size_t size{0};
+
+  MappedFile(const std::uint8_t *_data, std::size_t _size)
+      : data(_data), size(_size) {}
+
+public:
+  static std::expected<MappedFile, ArchiveError> open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return std::unexpected(ArchiveError::CANT_OPEN);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      return std::unexpected(ArchiveError::CANT_OPEN);
+    }
+    auto size = (std::size_t)info.st_size;
+    if (size == 0) {
+      ::close(fd);
+      return MappedFile{nullptr, 0};
+    }
+
+    auto mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file open
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+      return std::unexpected(ArchiveError::CANT_OPEN);
+    }
+    return MappedFile{static_cast<const std::uint8_t *>(mapped), size};
+  }
+
+  MappedFile(MappedFile &&other) noexcept
+      : data(std::exchange(other.data, nullptr)),
+        size(std::exchange(other.size, 0)) {}
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    return *this;
+  }
+
+  ~MappedFile() {
+    if (data) {
+      ::munmap((void *)data, size);
+    }
+  }
+
+  std::span<const std::uint8_t> bytes() const { return {data, size}; }
+};
+
+// Reads games out of an archive file, mapped read-only into memory
+template <ShapeFactory Factory>
+  requires std::constructible_from<Factory, std::uint64_t>
+class ReplayArchive {
+private:
+  using Keyframe = archive_detail::Keyframe<Factory>;
+
+  MappedFile file;
+  std::span<const std::uint8_t> index;
+  std::size_t games;
+  // Shared by every game, as in ArchiveWriter
+  archive_detail::KickTables<Factory> kickTables{Factory{0}};
+
+  ReplayArchive(MappedFile _file, std::span<const std::uint8_t> _index,
+                std::size_t _games)
+      : file(std::move(_file)), index(_index), games(_games) {}
+
+  archive_detail::IndexEntry entry(std::size_t game) const {
+    return archive_detail::load<archive_detail::IndexEntry>(
+        index.subspan(game * sizeof(archive_detail::IndexEntry)));
+  }
+
+  Keyframe loadKeyframe(const archive_detail::IndexEntry &entry,
+                        std::size_t i) const {
+    return archive_detail::load<Keyframe>(file.bytes().subspan(
+        entry.keyframesOffset + i * sizeof(Keyframe), sizeof(Keyframe)));
+  }
+
+  // Keyframe `i` with its kick tables put back, as long as it's safe to
+  // restore into a game of the size `header` describes
+  std::expected<Keyframe, ArchiveError>
+  restorableKeyframe(const archive_detail::IndexEntry &entry, std::size_t i,
+                     const ReplayHeader &header) const {
+    auto keyframe = loadKeyframe(entry, i);
+    if (not kickTables.decode(keyframe.state, keyframe.kickTables) or
+        not archive_detail::validState(keyframe.state, header.width,
+                                       header.height)) {
+      return std::unexpected(ArchiveError::BAD_FORMAT);
+    }
+    return keyframe;
+  }
+
+public:
+  static std::expected<ReplayArchive, ArchiveError>
+  open(const std::string &path) {
+    using namespace archive_detail;
+    auto file = MappedFile::open(path);
+    if (not file) {
+      return std::unexpected(file.error());
+    }
+
+    auto bytes = file->bytes();
+    if (bytes.size() < sizeof(FileHeader) + sizeof(Footer)) {
+      return std::unexpected(ArchiveError::BAD_FORMAT);
+    }
+    auto header = load<FileHeader>(bytes);
+    auto footer = load<Footer>(bytes.last(sizeof(Footer)));
+    if (header.magic != MAGIC or header.version != VERSION or
+        footer.magic != MAGIC or footer.version != VERSION) {
+      return std::unexpected(ArchiveError::BAD_FORMAT);
+    }
+    if (header.stateSize != sizeof(GameState<Factory>)) {
+      return std::unexpected(ArchiveError::WRONG_STATE_SIZE);
+    }
+
+    auto indexEnd = bytes.size() - sizeof(Footer);
+    if (footer.indexOffset > indexEnd or
+        (indexEnd - footer.indexOffset) / sizeof(IndexEntry) != footer.games) {
+      return std::unexpected(ArchiveError::BAD_FORMAT);
+    }
+    auto index = bytes.subspan(footer.indexOffset,
+                               footer.games * sizeof(IndexEntry));
+    for (std::size_t i = 0; i < footer.games; i++) {
+      auto entry = load<IndexEntry>(index.subspan(i * sizeof(IndexEntry)));
+      // Checked by subtracting, so that huge offsets and sizes can't wrap
+      // around into range
+      if (entry.replayOffset > footer.indexOffset or
+          entry.replaySize > footer.indexOffset - entry.replayOffset or
+          entry.keyframesOffset > footer.indexOffset or
+          entry.keyframeCount >
+              (footer.indexOffset - entry.keyframesOffset) / sizeof(Keyframe)) {
+        return std::unexpected(ArchiveError::BAD_FORMAT);
+      }
+    }
+    return ReplayArchive{std::move(*file), index, footer.games};
+  }
+
+  std::size_t size() const { return games; }
+
+  // The `i`th game, which must be less than size()
+  std::expected<ArchivedGame, ArchiveError> game(std::size_t i) const {
+    auto e = entry(i);
+    auto replay = file.bytes().subspan(e.replayOffset, e.replaySize);
+    auto reader = ReplayReader::open(replay);
+    if (not reader) {
+      return std::unexpected(ArchiveError::BAD_REPLAY);
+    }
+    return ArchivedGame{reader->getHeader(), replay, e.result};
+  }
+
+  std::size_t keyframeCount(std::size_t i) const {
+    return entry(i).keyframeCount;
+  }
+
+  // Keyframe `k` of game `i`, for k < keyframeCount(i)
+  std::expected<ArchivedKeyframe<Factory>, ArchiveError>
+  keyframe(std::size_t i, std::size_t k) const {
+    auto found = game(i);
+    if (not found) {
+      return std::unexpected(found.error());
+    }
+    auto loaded = restorableKeyframe(entry(i), k, found->header);
+    if (not loaded) {
+      return std::unexpected(loaded.error());
+    }
+    return ArchivedKeyframe<Factory>{loaded->events, loaded->frame,
+                                     loaded->state};
+  }
+
+  // Game `i` as it was at the end of `frame`, found by restoring the last
+  // keyframe at or before that frame and replaying from there
+  std::expected<Tetris<Factory>, ArchiveError> seek(std::size_t i,
+                                                    std::uint64_t frame) const {
+    auto e = entry(i);
+    auto reader =
+        ReplayReader::open(file.bytes().subspan(e.replayOffset, e.replaySize));
+    if (not reader) {
+      return std::unexpected(ArchiveError::BAD_REPLAY);
+    }
+    auto tetris = startReplay<Factory>(reader->getHeader());
+    if (not tetris) {
+      return std::unexpected(ArchiveError::BAD_GAME);
+    }
+
+    // Keyframes are in frame order, so find the first one past `frame` and
+    // take the one before it
+    auto after = *std::ranges::partition_point(
+        std::views::iota(std::uint64_t{0}, e.keyframeCount),
+        [&](std::uint64_t k) { return loadKeyframe(e, k).frame <= frame; });
+    if (after > 0) {
+      auto start = restorableKeyframe(e, after - 1, reader->getHeader());
+      if (not start) {
+        return std::unexpected(start.error());
+      }
+      tetris->restore(start->state);
+      reader->seek(start->position, start->frame);
+    }
+
+    while (true) {
+      auto event = reader->next();
+      if (not event) {
+        return std::unexpected(ArchiveError::BAD_REPLAY);
+      } else if (not *event or (*event)->frame > frame) {
+        return std::move(*tetris);
+      }
+      tetris->handleInput((*event)->input);
+    }
+  }
+};
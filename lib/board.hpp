@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+
+#include "zobrist.hpp"
+
+// The cells of a piece within its (at most 4x4) bounding box, with bit
+// `y * PIECE_MASK_SIZE + x` set when the cell at (x, y) is filled
+using PieceMask = std::uint16_t;
+constexpr int PIECE_MASK_SIZE = 4;
+
+// The cells of row `y` of a piece's bounding box, with bit `x` set when the
+// cell at (x, y) is filled
+constexpr std::uint16_t pieceRow(PieceMask mask, int y) {
+  return (mask >> (y * PIECE_MASK_SIZE)) & ((1u << PIECE_MASK_SIZE) - 1);
+}
+
+// Bitboard storage for the tetris playfield: one machine word per row, stored
+// contiguously from the bottom of the board upwards, with bit `x` of row `y`
+// set when the cell at (x, y) is filled
+class Board {
+public:
+  using Row = std::uint16_t;
+
+  constexpr static int MAX_WIDTH = std::numeric_limits<Row>::digits;
+  constexpr static int MAX_HEIGHT = 64;
+  static_assert(MAX_WIDTH <= zobrist::COLUMNS and MAX_HEIGHT <= zobrist::ROWS);
+
+private:
+  int width;
+  int height;
+  // Value of a row when every cell in it is filled
+  Row fullRow;
+  std::array<Row, MAX_HEIGHT> rows{};
+  // Number of rows up to and including the highest filled cell of each column
+  std::array<int, MAX_WIDTH> columnHeights{};
+  // Zobrist hash of the filled cells
+  std::uint64_t cellsHash{0};
+
+  bool columnFilled(int x, int y) const { return (rows[y] >> x) & 1; }
+
+  // Lowers the height of column `x`, which can be at most `upperBound`, to
+  // just above its highest filled cell
+  void settleColumn(int x, int upperBound) {
+    int h = upperBound;
+    while (h > 0 and not columnFilled(x, h - 1)) {
+      h--;
+    }
+    columnHeights[x] = h;
+  }
+
+public:
+  // A board with no cells, to be assigned over
+  Board() : Board(0, 0) {}
+  Board(int _width, int _height)
+      : width(_width), height(_height),
+        fullRow(static_cast<Row>((1u << _width) - 1)) {}
+
+  // Copies the board into `out` a member at a time, which leaves the padding
+  // between members in `out` as it was -- so the same boards copied into
+  // zeroed storage come out byte for byte the same
+  void copyMembersTo(Board &out) const {
+    out.width = width;
+    out.height = height;
+    out.fullRow = fullRow;
+    out.rows = rows;
+    out.columnHeights = columnHeights;
+    out.cellsHash = cellsHash;
+  }
+
+  // Whether the size, cells, column heights and hash all agree with each
+  // other, as they always do for a board that's been played on -- for checking
+  // boards read in from outside
+  bool consistent() const {
+    if (width < 1 or width > MAX_WIDTH or height < 1 or height > MAX_HEIGHT or
+        fullRow != static_cast<Row>((1u << width) - 1)) {
+      return false;
+    }
+    std::uint64_t expectedHash = 0;
+    for (int y = 0; y < MAX_HEIGHT; y++) {
+      if ((rows[y] & ~fullRow) or (y >= height and rows[y])) {
+        return false;
+      }
+      if (y < height) {
+        expectedHash ^= zobrist::row(y, rows[y]);
+      }
+    }
+    for (int x = 0; x < MAX_WIDTH; x++) {
+      int h = 0;
+      for (int y = 0; y < height; y++) {
+        if (columnFilled(x, y)) {
+          h = y + 1;
+        }
+      }
+      if (columnHeights[x] != h) {
+        return false;
+      }
+    }
+    return cellsHash == expectedHash;
+  }
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+
+  // Empties every cell, in place
+  void reset() {
+    rows.fill(0);
+    columnHeights.fill(0);
+    cellsHash = 0;
+  }
+
+  bool cellAt(int x, int y) const { return columnFilled(x, y); }
+  void setCellAt(int x, int y, bool b) {
+    if (columnFilled(x, y) != b) {
+      cellsHash ^= zobrist::keys.cells[y][x];
+    }
+    if (b) {
+      rows[y] |= static_cast<Row>(1u << x);
+      columnHeights[x] = std::max(columnHeights[x], y + 1);
+    } else {
+      rows[y] &= static_cast<Row>(~(1u << x));
+      settleColumn(x, columnHeights[x]);
+    }
+  }
+
+  int columnHeight(int x) const { return columnHeights[x]; }
+
+  // Zobrist hash of which cells are filled, kept up to date as cells change
+  std::uint64_t hash() const { return cellsHash; }
+
+  Row rowAt(int y) const { return rows[y]; }
+  bool rowFull(int y) const { return rows[y] == fullRow; }
+
+  // The rows that are in use, from the bottom of the board to the top
+  std::span<const Row> usedRows() const {
+    return {rows.data(), (size_t)height};
+  }
+
+  // Whether a piece placed with the bottom-left of its bounding box at (x, y)
+  // overlaps a filled cell or sticks out of the board
+  bool collides(PieceMask mask, int x, int y) const {
+    // Piece rows are shifted into a wider word with PIECE_MASK_SIZE bits of
+    // padding on the right, so cells past either wall are kept
+    if (x < -PIECE_MASK_SIZE or x > MAX_WIDTH) {
+      return mask != 0;
+    }
+    auto outside = ~(std::uint32_t{fullRow} << PIECE_MASK_SIZE);
+
+    for (int r = 0; r < PIECE_MASK_SIZE; r++) {
+      std::uint32_t cells = pieceRow(mask, r);
+      if (cells == 0) {
+        continue;
+      }
+      if (y + r < 0 or y + r >= height) {
+        return true;
+      }
+
+      auto shifted = cells << (x + PIECE_MASK_SIZE);
+      if ((shifted & outside) or ((shifted >> PIECE_MASK_SIZE) & rows[y + r])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Fills in the cells of a piece with the bottom-left of its bounding box at
+  // (x, y), which must be somewhere it doesn't collide
+  void place(PieceMask mask, int x, int y) {
+    for (int r = 0; r < PIECE_MASK_SIZE; r++) {
+      unsigned cells = pieceRow(mask, r);
+      if (cells == 0) {
+        continue;
+      }
+      cells = x >= 0 ? cells << x : cells >> -x;
+      cellsHash ^= zobrist::row(y + r, static_cast<Row>(cells & ~rows[y + r]));
+      rows[y + r] |= static_cast<Row>(cells);
+
+      for (; cells != 0; cells &= cells - 1) {
+        auto &h = columnHeights[std::countr_zero(cells)];
+        h = std::max(h, y + r + 1);
+      }
+    }
+  }
+
+  // How many rows a piece with the bottom-left of its bounding box at (x, y)
+  // can fall before landing on the floor or a filled cell
+  int dropDistance(PieceMask mask, int x, int y) const {
+    int distance = y + PIECE_MASK_SIZE;
+
+    for (int column = 0; column < PIECE_MASK_SIZE; column++) {
+      int bottom = 0;
+      while (bottom < PIECE_MASK_SIZE and
+             not((pieceRow(mask, bottom) >> column) & 1)) {
+        bottom++;
+      }
+      if (bottom == PIECE_MASK_SIZE) {
+        continue;
+      }
+
+      // The piece only lands on the surface of its columns when it's above it
+      // -- if it's been tucked under an overhang, we have to look row by row
+      int gap = y + bottom - columnHeights[x + column];
+      if (gap < 0) {
+        distance = 0;
+        while (not collides(mask, x, y - distance - 1)) {
+          distance++;
+        }
+        return distance;
+      }
+      distance = std::min(distance, gap);
+    }
+    return distance;
+  }
+
+  // Which of the `count` rows starting at row `y` are full, with bit `r` set
+  // when row `r` is
+  std::uint64_t fullRows(int y, int count) const {
+    std::uint64_t full = 0;
+    for (int r = std::max(y, 0); r < std::min(y + count, height); r++) {
+      full |= (std::uint64_t)(rows[r] == fullRow) << r;
+    }
+    return full;
+  }
+
+  // Removes the full rows out of the `count` rows starting at row `y`, letting
+  // the rows above them fall down
+  // Returns the number of rows removed
+  int clearRows(int y, int count) {
+    int begin = std::max(y, 0);
+    int end = std::min(y + count, height);
+
+    // Nothing below the first full row moves
+    while (begin < end and rows[begin] != fullRow) {
+      begin++;
+    }
+    if (begin == end) {
+      return 0;
+    }
+
+    // Every row from there up to the top of the stack can change, so their
+    // cells are hashed out now and back in once they've settled
+    int top = *std::max_element(columnHeights.begin(),
+                                columnHeights.begin() + width);
+    for (int r = begin; r < top; r++) {
+      cellsHash ^= zobrist::row(r, rows[r]);
+    }
+
+    // Compact the rows being looked at, dropping the full ones
+    int kept = begin;
+    for (int r = begin; r < end; r++) {
+      if (rows[r] != fullRow) {
+        rows[kept++] = rows[r];
+      }
+    }
+    int removed = end - kept;
+
+    // Then everything above falls down in one go
+    std::memmove(rows.data() + kept, rows.data() + end,
+                 (height - end) * sizeof(Row));
+    std::fill(rows.data() + height - removed, rows.data() + height, Row{0});
+
+    for (int r = begin; r < top - removed; r++) {
+      cellsHash ^= zobrist::row(r, rows[r]);
+    }
+
+    // Every full row reaches the top of every column, so each column loses at
+    // least as many rows as were cleared
+    for (int x = 0; x < width; x++) {
+      settleColumn(x, columnHeights[x] - removed);
+    }
+    return removed;
+  }
+
+  // Removes all full rows, letting the rows above them fall down
+  // Returns the number of rows removed
+  int clear() { return clearRows(0, height); }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <optional>
+
+#include "engine.hpp"
+#include "terminal.hpp"
+
+// Turns keys typed into a terminal into the buttons a TickEngine is run with
+//
+// A terminal only says when a key is typed, never when it's let go -- a key
+// that's held down is typed again and again by the terminal's key repeat. So
+// each key holds its button down for a few frames, long enough to last until
+// the next repeat, and a held key keeps its button held: shifting repeats and
+// soft drop keeps going as they would on a controller
+
+// The button a key presses, if any
+inline std::optional<Button> buttonFor(TerminalKey key) {
+  switch (key.code) {
+  case KeyCode::LEFT:
+    return Button::LEFT;
+  case KeyCode::RIGHT:
+    return Button::RIGHT;
+  case KeyCode::DOWN:
+    return Button::SOFT_DROP;
+  case KeyCode::UP:
+    return Button::CLOCKWISE;
+  case KeyCode::CHARACTER:
+    switch (key.character) {
+    case ' ':
+      return Button::HARD_DROP;
+    case 'c':
+      return Button::HOLD;
+    case 'q':
+      return Button::COUNTER_CLOCKWISE;
+    case 'e':
+      return Button::CLOCKWISE;
+    default:
+      return std::nullopt;
+    }
+  default:
+    return std::nullopt;
+  }
+}
+
+// Ctrl-C and Ctrl-D, which arrive as keys in raw mode
+inline bool quits(TerminalKey key) {
+  return key.code == KeyCode::CHARACTER and
+         (key.character == '\x03' or key.character == '\x04');
+}
+
+// The buttons held down by the keys typed so far
+class KeyButtons {
+public:
+  // How many frames a key holds its button for: a little longer than the
+  // gap between repeats of a held key (usually 30-50ms), and long enough that
+  // a single tap of soft drop moves a shape at least a row at level 1
+  constexpr static int HOLD_FRAMES = 4;
+
+private:
+  // How many more frames each button is held for
+  std::array<int, (int)Button::HOLD + 1> remaining{};
+
+public:
+  // Presses the button for `key`, or keeps it held if it already is
+  // Returns whether the key is for a button
+  bool press(TerminalKey key) {
+    auto button = buttonFor(key);
+    if (button) {
+      remaining[(int)*button] = HOLD_FRAMES;
+    }
+    return button.has_value();
+  }
+
+  // The buttons held on the next frame, which counts their holds down by one
+  Buttons next() {
+    Buttons held;
+    for (int button = 0; button < (int)remaining.size(); button++) {
+      if (remaining[button] > 0) {
+        remaining[button]--;
+        held.bits |= Buttons::bit((Button)button);
+      }
+    }
+    return held;
+  }
+};
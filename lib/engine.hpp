@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+#include "tetris.hpp"
+
+// Runs a game in real time, a fixed 60 frames a second, from the buttons held
+// down on each frame: shapes fall under gravity, lock after a delay once they
+// land, and shift repeatedly while left or right is held
+//
+// Everything is counted in whole frames and gravity builds up in fractions of a
+// cell, so a game plays out the same on every machine and a tick is only a few
+// integer operations
+
+namespace gravity {
+constexpr int FRAMES_PER_SECOND = 60;
+// Distances fallen are measured in 65536ths of a cell
+constexpr std::uint32_t CELL = 1 << 16;
+// Gravity stops getting faster after this level
+constexpr int MAX_LEVEL = 20;
+// The 20G cap: however fast gravity gets, a shape falls at most 20 cells a frame
+constexpr std::uint32_t MAX = 20 * CELL;
+
+// The guideline's curve, where a shape takes
+//
+//   (0.8 - (level - 1) * 0.007) ^ (level - 1)
+//
+// seconds to fall a row, as how far it falls each frame
+constexpr std::array<std::uint32_t, MAX_LEVEL> makeCurve() {
+  std::array<std::uint32_t, MAX_LEVEL> curve{};
+  for (int level = 1; level <= MAX_LEVEL; level++) {
+    double seconds = 1;
+    for (int i = 1; i < level; i++) {
+      seconds *= 0.8 - (level - 1) * 0.007;
+    }
+    double perFrame = CELL / (seconds * FRAMES_PER_SECOND);
+    curve[level - 1] = perFrame >= MAX ? MAX : (std::uint32_t)(perFrame + 0.5);
+  }
+  return curve;
+}
+
+inline constexpr std::array<std::uint32_t, MAX_LEVEL> curve = makeCurve();
+
+// How far a shape falls each frame at `level`
+constexpr std::uint32_t perFrame(int level) {
+  return curve[std::clamp(level, 1, MAX_LEVEL) - 1];
+}
+} // namespace gravity
+
+enum class Button : std::uint8_t {
+  LEFT,
+  RIGHT,
+  SOFT_DROP,
+  HARD_DROP,
+  CLOCKWISE,
+  COUNTER_CLOCKWISE,
+  HOLD
+};
+
+// The buttons held down on a frame, a bit each
+struct Buttons {
+  std::uint8_t bits{0};
+
+  constexpr Buttons() = default;
+  constexpr Buttons(std::initializer_list<Button> buttons) {
+    for (auto button : buttons) {
+      bits |= bit(button);
+    }
+  }
+
+  constexpr static std::uint8_t bit(Button button) {
+    return (std::uint8_t)(1u << (int)button);
+  }
+  constexpr bool operator[](Button button) const { return bits & bit(button); }
+  constexpr bool operator==(const Buttons &other) const = default;
+};
+
+// Timings, all in frames
+struct Timing {
+  // How long left or right has to be held before the shape starts shifting
+  // again (delayed auto shift), then how often it shifts after that (auto
+  // repeat rate) -- 0 shifts it all the way over at once
+  int das{10};
+  int arr{2};
+  // How long a shape sits on the stack before it locks
+  int lockDelay{30};
+  // How many times moving or rotating a landed shape can restart its lock
+  // delay, before it locks as soon as it lands. Falling to a new lowest row
+  // starts the count again
+  int maxLockResets{15};
+  // How many times faster than gravity soft drop is
+  int softDropFactor{20};
+};
+
+// Where the engine is up to between frames, which is trivially copyable so
+// it can be snapshotted along with the game -- see TickEngine::snapshot
+struct TickState {
+  std::uint64_t frame{0};
+  // The buttons held on the last frame, to tell when they're pressed
+  Buttons held{};
+  // How far the shape in play has fallen towards the next row
+  std::uint32_t fallen{0};
+
+  // Whether the shape has landed since it reached its lowest row, and so is
+  // counting down to locking
+  bool landed{false};
+  int lockTimer{0};
+  int lockResets{0};
+  int lowestRow{0};
+
+  // The way the shape is being shifted: -1 for left, 1 for right or 0, and for
+  // how many frames
+  int shiftDirection{0};
+  int shiftTimer{0};
+};
+
+// Everything about a game being run in real time that changes from frame to
+// frame: the game itself, and how far it's got towards falling, locking and
+// shifting
+template <ShapeFactory Factory> struct EngineState {
+  GameState<Factory> game;
+  TickState tick;
+};
+
+template <ShapeFactory Factory> class TickEngine {
+private:
+  Tetris<Factory> tetris;
+  Timing timing;
+  TickState state;
+
+  // A new shape has come into play, so it starts afresh
+  void spawned() {
+    state.fallen = 0;
+    state.landed = false;
+    state.lockTimer = 0;
+    state.lockResets = 0;
+    state.lowestRow = tetris.getShapeLocation().y;
+  }
+
+  void moved() {
+    if (tetris.getShapeLocation().y < state.lowestRow) {
+      state.lowestRow = tetris.getShapeLocation().y;
+      state.landed = false;
+      state.lockTimer = 0;
+      state.lockResets = 0;
+    } else if (state.landed and state.lockResets < timing.maxLockResets) {
+      state.lockTimer = 0;
+      state.lockResets++;
+    }
+  }
+
+  // Plays an input into the game, keeping track of the shape in play
+  // Returns whether it moved or rotated the shape
+  bool play(Input input) {
+    auto pieces = tetris.getPieces();
+    auto couldHold = tetris.canHold();
+    auto location = tetris.getShapeLocation();
+    auto rotation = tetris.getCurrentShape().rotationIndex;
+    tetris.handleInput(input);
+
+    if (tetris.getPieces() != pieces or tetris.canHold() != couldHold) {
+      spawned();
+      return false;
+    } else if (tetris.getShapeLocation() == location and
+               tetris.getCurrentShape().rotationIndex == rotation) {
+      return false;
+    }
+    moved();
+    return true;
+  }
+
+  void shift(Buttons buttons, Buttons pressed) {
+    // Whichever of left and right was pressed last wins while both are held
+    auto held = [&](int direction) {
+      return (direction < 0 and buttons[Button::LEFT]) or
+             (direction > 0 and buttons[Button::RIGHT]);
+    };
+    int direction = 0;
+    if (pressed[Button::LEFT] or pressed[Button::RIGHT]) {
+      direction = pressed[Button::LEFT] ? -1 : 1;
+    } else if (held(state.shiftDirection)) {
+      direction = state.shiftDirection;
+    } else if (held(-1) or held(1)) {
+      direction = held(-1) ? -1 : 1;
+    }
+    if (direction == 0) {
+      state.shiftDirection = 0;
+      return;
+    }
+
+    Input input = direction < 0 ? Direction::LEFT : Direction::RIGHT;
+    if (direction != state.shiftDirection) {
+      state.shiftDirection = direction;
+      state.shiftTimer = 0;
+      play(input);
+      return;
+    }
+
+    state.shiftTimer++;
+    if (state.shiftTimer < timing.das) {
+      return;
+    } else if (timing.arr == 0) {
+      while (play(input)) {
+      }
+    } else if ((state.shiftTimer - timing.das) % timing.arr == 0) {
+      play(input);
+    }
+  }
+
+  void fall(bool softDrop) {
+    if (tetris.isGrounded()) {
+      state.fallen = 0;
+      return;
+    }
+    auto perFrame = gravity::perFrame(tetris.getLevel());
+    if (softDrop) {
+      perFrame = std::min(perFrame * timing.softDropFactor, gravity::MAX);
+    }
+
+    state.fallen += perFrame;
+    while (state.fallen >= gravity::CELL and not tetris.isGrounded()) {
+      state.fallen -= gravity::CELL;
+      play(Direction::DOWN);
+    }
+    if (tetris.isGrounded()) {
+      state.fallen = 0;
+    }
+  }
+
+  void lock() {
+    if (not tetris.isGrounded()) {
+      return;
+    }
+    state.landed = true;
+    state.lockTimer++;
+    if (state.lockTimer >= timing.lockDelay or
+        state.lockResets >= timing.maxLockResets) {
+      // Moving a grounded shape down locks it
+      play(Direction::DOWN);
+    }
+  }
+
+public:
+  explicit TickEngine(Tetris<Factory> _tetris, Timing _timing = {})
+      : tetris{std::move(_tetris)}, timing{_timing} {
+    spawned();
+  }
+
+  const Tetris<Factory> &getTetris() const { return tetris; }
+  const TickState &getState() const { return state; }
+  // Number of frames run so far
+  std::uint64_t frame() const { return state.frame; }
+
+  // A copy of the game and its timing as they are between frames
+  EngineState<Factory> snapshot() const { return {tetris.snapshot(), state}; }
+
+  // Puts the game and its timing back to how they were when `snapshot` was
+  // taken, so that gravity, lock delay and shifting carry on from that frame
+  void restore(const EngineState<Factory> &snapshot) {
+    tetris.restore(snapshot.game);
+    state = snapshot.tick;
+  }
+
+  // Runs a frame with `buttons` held down. Holding, rotating and hard
+  // dropping happen once when their button is pressed, however long it's held
+  void tick(Buttons buttons) {
+    Buttons pressed;
+    pressed.bits = buttons.bits & ~state.held.bits;
+    state.held = buttons;
+    state.frame++;
+    if (tetris.isToppedOut()) {
+      return;
+    }
+
+    if (pressed[Button::HOLD]) {
+      play(Key::HOLD);
+    }
+    if (pressed[Button::CLOCKWISE]) {
+      play(Rotation::CLOCKWISE);
+    }
+    if (pressed[Button::COUNTER_CLOCKWISE]) {
+      play(Rotation::COUNTER_CLOCKWISE);
+    }
+    if (pressed[Button::HARD_DROP]) {
+      play(Key::SPACE);
+      return;
+    }
+
+    shift(buttons, pressed);
+    fall(buttons[Button::SOFT_DROP]);
+    lock();
+  }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "board.hpp"
+
+// Measures of how good a board is to keep playing on
+struct BoardFeatures {
+  // Sum of the heights of every column, and the tallest of them
+  int aggregateHeight{0};
+  int maxHeight{0};
+  // Empty cells with a filled cell somewhere above them
+  int holes{0};
+  // Sum of the height differences between neighbouring columns
+  int bumpiness{0};
+  // Empty cells with both sides filled (or against a wall)
+  int wells{0};
+  // Changes between filled and empty cells along each row (with the walls
+  // counting as filled) and up each column (with the floor counting as filled)
+  int rowTransitions{0};
+  int columnTransitions{0};
+
+  auto operator<=>(const BoardFeatures &other) const = default;
+};
+
+// How much each feature counts towards a board's score -- they're all bad, so
+// the weights are negative, other than for clearing lines
+struct EvaluationWeights {
+  float aggregateHeight{-0.51f};
+  float maxHeight{-0.1f};
+  float holes{-3.6f};
+  float bumpiness{-0.18f};
+  float wells{-0.3f};
+  float rowTransitions{-0.32f};
+  float columnTransitions{-0.93f};
+  float linesCleared{0.76f};
+};
+
+// Works out BoardFeatures from the rows of a Board, looking at many rows at
+// once with AVX2 or SSSE3 when the build targets them, and one at a time
+// otherwise
+class BoardEvaluator {
+public:
+  using Row = Board::Row;
+
+  // Per-row features, summed over the rows of the stack
+  struct RowSums {
+    int filled{0};
+    int wells{0};
+    int rowTransitions{0};
+    int columnTransitions{0};
+
+    auto operator<=>(const RowSums &other) const = default;
+  };
+
+private:
+  // Rows padded so that vector loads never run past the end: the row below
+  // the floor is full, and everything past the top of the board is empty
+  // The rows from the board start at PADDED_START
+  constexpr static int PADDED_START = 1;
+  constexpr static int PADDED_SIZE = Board::MAX_HEIGHT + 32;
+
+  // Bit masks that only depend on the width of the board
+  struct WidthMasks {
+    Row full;
+    // Bits that have a neighbour to their left in the row
+    Row pairs;
+    // The bits against the left and right walls
+    Row left;
+    Row right;
+
+    explicit WidthMasks(int width)
+        : full(static_cast<Row>((1u << width) - 1)),
+          pairs(static_cast<Row>((1u << (width - 1)) - 1)), left(1),
+          right(static_cast<Row>(1u << (width - 1))) {}
+  };
+
+  static auto paddedRows(const Board &board, const WidthMasks &masks) {
+    alignas(32) std::array<Row, PADDED_SIZE> padded{};
+    padded[PADDED_START - 1] = masks.full;
+    auto rows = board.usedRows();
+    std::memcpy(padded.data() + PADDED_START, rows.data(),
+                rows.size() * sizeof(Row));
+    return padded;
+  }
+
+  static RowSums rowSumsScalar(const Row *rows, int top,
+                               const WidthMasks &masks) {
+    RowSums sums;
+    for (int y = 0; y <= top; y++) {
+      Row row = rows[y];
+      Row below = rows[y - 1];
+      sums.columnTransitions += std::popcount(static_cast<Row>(row ^ below));
+      if (y == top) {
+        break;
+      }
+
+      sums.filled += std::popcount(row);
+      sums.rowTransitions +=
+          std::popcount(static_cast<Row>((row ^ (row >> 1)) & masks.pairs)) +
+          std::popcount(static_cast<Row>(~row & (masks.left | masks.right)));
+      Row leftFilled = static_cast<Row>((row << 1) | masks.left);
+      Row rightFilled = static_cast<Row>((row >> 1) | masks.right);
+      sums.wells += std::popcount(
+          static_cast<Row>(~row & masks.full & leftFilled & rightFilled));
+    }
+    return sums;
+  }
+
+#if defined(__AVX2__)
+  // Number of set bits in each 16-bit lane, summed over the whole vector
+  static int popcountSum(__m256i v) {
+    const auto lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto low = _mm256_set1_epi8(0x0f);
+    auto counts = _mm256_add_epi8(
+        _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+        _mm256_shuffle_epi8(lookup,
+                            _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    auto sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    return (int)(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                 _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+  }
+
+  static RowSums rowSumsVector(const Row *rows, int top,
+                               const WidthMasks &masks) {
+    constexpr int LANES = 16;
+    const auto full = _mm256_set1_epi16((short)masks.full);
+    const auto pairs = _mm256_set1_epi16((short)masks.pairs);
+    const auto edges = _mm256_set1_epi16((short)(masks.left | masks.right));
+    const auto left = _mm256_set1_epi16((short)masks.left);
+    const auto right = _mm256_set1_epi16((short)masks.right);
+    const auto lanes = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                         12, 13, 14, 15);
+
+    RowSums sums;
+    for (int y = 0; y <= top; y += LANES) {
+      auto row = _mm256_loadu_si256((const __m256i *)(rows + y));
+      auto below = _mm256_loadu_si256((const __m256i *)(rows + y - 1));
+      auto index = _mm256_add_epi16(lanes, _mm256_set1_epi16((short)y));
+      // Lanes in the stack, and lanes up to and including the row above it
+      auto inStack = _mm256_cmpgt_epi16(_mm256_set1_epi16((short)top), index);
+      auto toTop =
+          _mm256_cmpgt_epi16(_mm256_set1_epi16((short)(top + 1)), index);
+
+      sums.columnTransitions +=
+          popcountSum(_mm256_and_si256(_mm256_xor_si256(row, below), toTop));
+      sums.filled += popcountSum(_mm256_and_si256(row, inStack));
+
+      auto inside = _mm256_and_si256(
+          _mm256_xor_si256(row, _mm256_srli_epi16(row, 1)), pairs);
+      auto atWalls = _mm256_andnot_si256(row, edges);
+      sums.rowTransitions += popcountSum(_mm256_and_si256(inside, inStack)) +
+                             popcountSum(_mm256_and_si256(atWalls, inStack));
+
+      auto leftFilled = _mm256_or_si256(_mm256_slli_epi16(row, 1), left);
+      auto rightFilled = _mm256_or_si256(_mm256_srli_epi16(row, 1), right);
+      auto wells = _mm256_and_si256(
+          _mm256_andnot_si256(row, full),
+          _mm256_and_si256(leftFilled, rightFilled));
+      sums.wells += popcountSum(_mm256_and_si256(wells, inStack));
+    }
+    return sums;
+  }
+#elif defined(__SSSE3__)
+  // Number of set bits in each 16-bit lane, summed over the whole vector
+  static int popcountSum(__m128i v) {
+    const auto lookup =
+        _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto low = _mm_set1_epi8(0x0f);
+    auto counts = _mm_add_epi8(
+        _mm_shuffle_epi8(lookup, _mm_and_si128(v, low)),
+        _mm_shuffle_epi8(lookup, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+    auto sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sums) +
+           _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+  }
+
+  static RowSums rowSumsVector(const Row *rows, int top,
+                               const WidthMasks &masks) {
+    constexpr int LANES = 8;
+    const auto full = _mm_set1_epi16((short)masks.full);
+    const auto pairs = _mm_set1_epi16((short)masks.pairs);
+    const auto edges = _mm_set1_epi16((short)(masks.left | masks.right));
+    const auto left = _mm_set1_epi16((short)masks.left);
+    const auto right = _mm_set1_epi16((short)masks.right);
+    const auto lanes = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+
+    RowSums sums;
+    for (int y = 0; y <= top; y += LANES) {
+      auto row = _mm_loadu_si128((const __m128i *)(rows + y));
+      auto below = _mm_loadu_si128((const __m128i *)(rows + y - 1));
+      auto index = _mm_add_epi16(lanes, _mm_set1_epi16((short)y));
+      // Lanes in the stack, and lanes up to and including the row above it
+      auto inStack = _mm_cmplt_epi16(index, _mm_set1_epi16((short)top));
+      auto toTop = _mm_cmplt_epi16(index, _mm_set1_epi16((short)(top + 1)));
+
+      sums.columnTransitions +=
+          popcountSum(_mm_and_si128(_mm_xor_si128(row, below), toTop));
+      sums.filled += popcountSum(_mm_and_si128(row, inStack));
+
+      auto inside =
+          _mm_and_si128(_mm_xor_si128(row, _mm_srli_epi16(row, 1)), pairs);
+      auto atWalls = _mm_andnot_si128(row, edges);
+      sums.rowTransitions += popcountSum(_mm_and_si128(inside, inStack)) +
+                             popcountSum(_mm_and_si128(atWalls, inStack));
+
+      auto leftFilled = _mm_or_si128(_mm_slli_epi16(row, 1), left);
+      auto rightFilled = _mm_or_si128(_mm_srli_epi16(row, 1), right);
+      auto wells = _mm_and_si128(_mm_andnot_si128(row, full),
+                                 _mm_and_si128(leftFilled, rightFilled));
+      sums.wells += popcountSum(_mm_and_si128(wells, inStack));
+    }
+    return sums;
+  }
+#else
+  static RowSums rowSumsVector(const Row *rows, int top,
+                               const WidthMasks &masks) {
+    return rowSumsScalar(rows, top, masks);
+  }
+#endif
+
+public:
+  // Which version of rowSums the build compiled in
+#if defined(__AVX2__)
+  constexpr static std::string_view KERNEL = "avx2";
+#elif defined(__SSSE3__)
+  constexpr static std::string_view KERNEL = "ssse3";
+#else
+  constexpr static std::string_view KERNEL = "scalar";
+#endif
+
+  // The per-row sums for the rows below `top`, one row at a time -- a
+  // reference for the vectorised version
+  static RowSums rowSumsReference(const Board &board, int top) {
+    WidthMasks masks{board.getWidth()};
+    auto padded = paddedRows(board, masks);
+    return rowSumsScalar(padded.data() + PADDED_START, top, masks);
+  }
+
+  static RowSums rowSums(const Board &board, int top) {
+    WidthMasks masks{board.getWidth()};
+    auto padded = paddedRows(board, masks);
+    return rowSumsVector(padded.data() + PADDED_START, top, masks);
+  }
+
+  static BoardFeatures features(const Board &board) {
+    BoardFeatures result;
+    int width = board.getWidth();
+    for (int x = 0; x < width; x++) {
+      int h = board.columnHeight(x);
+      result.aggregateHeight += h;
+      result.maxHeight = std::max(result.maxHeight, h);
+      if (x > 0) {
+        result.bumpiness += std::abs(h - board.columnHeight(x - 1));
+      }
+    }
+
+    auto sums = rowSums(board, result.maxHeight);
+    // Every cell up to the top of its column is either filled or a hole
+    result.holes = result.aggregateHeight - sums.filled;
+    result.wells = sums.wells;
+    result.rowTransitions = sums.rowTransitions;
+    result.columnTransitions = sums.columnTransitions;
+    return result;
+  }
+
+  static float score(const BoardFeatures &features, int linesCleared,
+                     const EvaluationWeights &weights = {}) {
+    return weights.aggregateHeight * (float)features.aggregateHeight +
+           weights.maxHeight * (float)features.maxHeight +
+           weights.holes * (float)features.holes +
+           weights.bumpiness * (float)features.bumpiness +
+           weights.wells * (float)features.wells +
+           weights.rowTransitions * (float)features.rowTransitions +
+           weights.columnTransitions * (float)features.columnTransitions +
+           weights.linesCleared * (float)linesCleared;
+  }
+
+  static float score(const Board &board, int linesCleared,
+                     const EvaluationWeights &weights = {}) {
+    return score(features(board), linesCleared, weights);
+  }
+};
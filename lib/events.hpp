@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include "board.hpp"
+#include "ring_buffer.hpp"
+#include "scoring.hpp"
+
+// What happens in a game, as it happens, for renderers and stats to follow
+// without having to compare boards. A lock comes out as
+//
+//   LOCK, then CLEAR if it filled any rows, then SPAWN or GAME_OVER
+//
+// and a hold as HOLD then SPAWN
+
+enum class EventType : std::uint8_t { SPAWN, LOCK, CLEAR, HOLD, GAME_OVER };
+
+struct GameEvent {
+  EventType type;
+  // Number of shapes locked so far, counting the one a LOCK is for
+  std::int32_t piece{0};
+
+  // The shape that spawned, locked or went into hold, as its cells in its
+  // bounding box with the bottom-left at (x, y) -- which for a hold is where
+  // it was taken from
+  PieceMask mask{0};
+  std::int8_t x{0};
+  std::int8_t y{0};
+
+  // For a lock, what it cleared and scored
+  Lock lock{};
+  // For a clear, the rows that were cleared, with bit `y` set for row `y` as
+  // it was numbered before the clear
+  std::uint64_t rows{0};
+};
+
+// Where a game writes its events: preallocated, so writing one never
+// allocates, and safe for another thread to read from
+using EventQueue = SpscRingBuffer<GameEvent, 1024>;
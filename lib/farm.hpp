@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "simulator.hpp"
+
+// A fixed set of worker threads for running batches of independent tasks. Each
+// worker starts a batch with its own contiguous share of the tasks, and once
+// that runs dry it steals half of what's left from another worker
+class WorkStealingPool {
+private:
+  // Tasks waiting to be run by a worker, as the range [begin, end)
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    int begin{0};
+    int end{0};
+  };
+
+  std::vector<std::thread> threads;
+  std::unique_ptr<Queue[]> queues;
+  unsigned workers;
+
+  // The batch being run, type-erased so that submitting one doesn't allocate
+  void (*job)(void *, int, unsigned){nullptr};
+  void *jobContext{nullptr};
+  std::exception_ptr jobError;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::uint64_t generation{0};
+  unsigned busy{0};
+  bool stopping = false;
+
+  bool takeOwn(unsigned worker, int &task) {
+    auto &queue = queues[worker];
+    std::lock_guard lock{queue.mutex};
+    if (queue.begin == queue.end) {
+      return false;
+    }
+    task = queue.begin++;
+    return true;
+  }
+
+  bool steal(unsigned worker, int &task) {
+    for (unsigned i = 1; i < workers; i++) {
+      auto &victim = queues[(worker + i) % workers];
+      int begin, end;
+      {
+        std::lock_guard lock{victim.mutex};
+        if (victim.begin == victim.end) {
+          continue;
+        }
+        // Take the back half, leaving the victim the tasks it'll get to first
+        begin = victim.begin + (victim.end - victim.begin) / 2;
+        end = victim.end;
+        victim.end = begin;
+      }
+
+      auto &queue = queues[worker];
+      std::lock_guard lock{queue.mutex};
+      queue.begin = begin + 1;
+      queue.end = end;
+      task = begin;
+      return true;
+    }
+    return false;
+  }
+
+  void runTasks(unsigned worker) {
+    int task;
+    while (takeOwn(worker, task) or steal(worker, task)) {
+      try {
+        job(jobContext, task, worker);
+      } catch (...) {
+        std::lock_guard lock{mutex};
+        if (not jobError) {
+          jobError = std::current_exception();
+        }
+      }
+    }
+  }
+
+  void workerLoop(unsigned worker) {
+    std::uint64_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock lock{mutex};
+        wake.wait(lock, [&] { return stopping or generation != seen; });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+      }
+
+      runTasks(worker);
+
+      std::lock_guard lock{mutex};
+      if (--busy == 0) {
+        done.notify_one();
+      }
+    }
+  }
+
+public:
+  explicit WorkStealingPool(
+      unsigned _workers = std::max(1u, std::thread::hardware_concurrency()))
+      : queues{std::make_unique<Queue[]>(std::max(1u, _workers))},
+        workers{std::max(1u, _workers)} {
+    // The thread that submits a batch works on it too, as worker 0
+    for (unsigned i = 1; i < workers; i++) {
+      threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard lock{mutex};
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  unsigned size() const { return workers; }
+
+  // Calls `f(task, worker)` for every task in [0, count), spread across the
+  // workers, and returns once they've all finished. `worker` is below size(),
+  // and no two calls with the same worker run at once, so it can index
+  // per-worker state
+  // If any call throws, the first exception is rethrown once the batch is done
+  // Batches can only be submitted from one thread at a time
+  template <typename F> void parallelFor(int count, F &&f) {
+    for (unsigned i = 0; i < workers; i++) {
+      queues[i].begin = (int)((std::int64_t)count * i / workers);
+      queues[i].end = (int)((std::int64_t)count * (i + 1) / workers);
+    }
+    job = [](void *context, int task, unsigned worker) {
+      (*static_cast<std::remove_reference_t<F> *>(context))(task, worker);
+    };
+    jobContext = &f;
+    jobError = nullptr;
+
+    {
+      std::lock_guard lock{mutex};
+      busy = workers - 1;
+      generation++;
+    }
+    wake.notify_all();
+
+    runTasks(0);
+
+    {
+      std::unique_lock lock{mutex};
+      done.wait(lock, [this] { return busy == 0; });
+    }
+    if (jobError) {
+      std::rethrow_exception(jobError);
+    }
+  }
+};
+
+// A single game for the farm to play: the seed for its piece source, and the
+// inputs to play through
+struct FarmGame {
+  std::uint64_t seed;
+  std::span<const Input> inputs;
+};
+
+// Plays every game independently across the pool. Each game gets its own piece
+// source from `makeFactory(seed)`, so games share no state and are reproducible
+// from their seeds
+// Returns the results in the same order as the games
+template <ShapeFactory Factory, typename MakeFactory>
+  requires std::is_invocable_r_v<Factory, MakeFactory &, std::uint64_t>
+std::vector<SimulationStats> playGames(WorkStealingPool &pool,
+                                       std::span<const FarmGame> games,
+                                       MakeFactory makeFactory) {
+  std::vector<SimulationStats> results(games.size());
+  // Each worker plays all its games on one simulator, resetting it in between
+  std::vector<std::optional<Simulator<Factory>>> simulators(pool.size());
+
+  pool.parallelFor((int)games.size(), [&](int game, unsigned worker) {
+    auto &simulator = simulators[worker];
+    if (simulator) {
+      simulator->reset(makeFactory(games[game].seed));
+    } else {
+      simulator.emplace(makeFactory(games[game].seed));
+    }
+    results[game] = simulator->run(games[game].inputs);
+  });
+  return results;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "tetris.hpp"
+
+// Where a shape can end up: the bottom-left of its bounding box, and which
+// rotation it's in
+struct Placement {
+  Coord location;
+  int rotationIndex;
+
+  auto operator<=>(const Placement &other) const = default;
+};
+
+// Finds every distinct place the current shape can be locked into, by a
+// breadth-first search over (x, y, rotation) from where the shape is now
+//
+// Moving down goes a row at a time, since the shape can be stopped partway down
+// to shift or spin into an overhang (like a cave halfway down a well) that it
+// can't get back up to from below
+//
+// All of the search state lives inside the generator, so generating doesn't
+// allocate: keep one around and reuse it
+class MoveGenerator {
+private:
+  // Bounding boxes can hang up to PIECE_MASK_SIZE - 1 cells off the board
+  constexpr static int X_STATES = Board::MAX_WIDTH + PIECE_MASK_SIZE;
+  constexpr static int Y_STATES = Board::MAX_HEIGHT + PIECE_MASK_SIZE;
+  constexpr static int STATES = X_STATES * Y_STATES * 4;
+
+  using State = std::uint16_t;
+  static_assert(STATES <= std::numeric_limits<State>::max());
+
+  // How a state was first reached
+  enum class Move : std::uint8_t {
+    START,
+    LEFT,
+    RIGHT,
+    CLOCKWISE,
+    COUNTER_CLOCKWISE,
+    DROP
+  };
+
+  std::bitset<STATES> visited;
+  // Placements with the same cells as one already found
+  std::bitset<STATES> landed;
+  std::array<State, STATES> queue;
+  std::array<State, STATES> parents;
+  std::array<Move, STATES> moves;
+  std::array<Placement, STATES> placements;
+  // Where each rotation of the shape fits: bit x + PIECE_MASK_SIZE of
+  // fits[rotation][y + PIECE_MASK_SIZE] is set when the shape doesn't collide
+  // with its bounding box's bottom-left at (x, y). Worked out a row at a time
+  // up front, so the search itself only tests bits
+  std::array<std::array<std::uint32_t, Y_STATES>, 4> fits;
+
+  static State stateOf(Coord location, int rotationIndex) {
+    return (State)((rotationIndex * Y_STATES + location.y + PIECE_MASK_SIZE) *
+                       X_STATES +
+                   location.x + PIECE_MASK_SIZE);
+  }
+  static Placement placementOf(State state) {
+    return {{state % X_STATES - PIECE_MASK_SIZE,
+             state / X_STATES % Y_STATES - PIECE_MASK_SIZE},
+            state / (X_STATES * Y_STATES)};
+  }
+
+  // Where the filled cells of each rotation's mask start, relative to the
+  // bottom-left of its bounding box
+  static Coord maskOrigin(PieceMask mask) {
+    Coord origin{PIECE_MASK_SIZE, PIECE_MASK_SIZE};
+    for (int y = 0; y < PIECE_MASK_SIZE; y++) {
+      if (auto row = pieceRow(mask, y)) {
+        origin.x = std::min(origin.x, std::countr_zero(row));
+        origin.y = std::min(origin.y, y);
+      }
+    }
+    return origin;
+  }
+
+  // Fills in `fits` for `masks`, the same as Board::collides would answer
+  void findFits(const Board &board, const std::array<PieceMask, 4> &masks) {
+    // The cells of each row a shape can't overlap, shifted over like `fits`:
+    // the filled cells and everything past the walls, and every cell of the
+    // rows off the top and bottom of the board
+    std::array<std::uint32_t, Y_STATES + PIECE_MASK_SIZE> blocked;
+    auto walls = ~((std::uint32_t)((1u << board.getWidth()) - 1)
+                   << PIECE_MASK_SIZE);
+    for (int i = 0; i < (int)blocked.size(); i++) {
+      auto y = i - PIECE_MASK_SIZE;
+      blocked[i] = y < 0 or y >= board.getHeight()
+                       ? ~std::uint32_t{0}
+                       : walls | (std::uint32_t)board.rowAt(y)
+                                     << PIECE_MASK_SIZE;
+    }
+
+    for (int r = 0; r < 4; r++) {
+      for (int i = 0; i < Y_STATES; i++) {
+        std::uint32_t collides = 0;
+        for (int row = 0; row < PIECE_MASK_SIZE; row++) {
+          for (unsigned cells = pieceRow(masks[r], row); cells != 0;
+               cells &= cells - 1) {
+            collides |= blocked[i + row] >> std::countr_zero(cells);
+          }
+        }
+        fits[r][i] = ~collides & ((1u << X_STATES) - 1);
+      }
+    }
+  }
+
+  bool fit(Coord location, int rotationIndex) const {
+    auto x = location.x + PIECE_MASK_SIZE;
+    auto y = location.y + PIECE_MASK_SIZE;
+    return x >= 0 and x < X_STATES and y >= 0 and y < Y_STATES and
+           (fits[rotationIndex][y] >> x) & 1;
+  }
+
+public:
+  std::span<const Placement> generate(const Board &board, const Shape &shape,
+                                      Coord location) {
+    if (board.collides(shape.mask(), location.x, location.y)) {
+      return {};
+    }
+    findFits(board, shape.rotations);
+
+    // Rotations that fill the same cells as another rotation (like all of an
+    // O's) are told apart by the rotation they canonically map to, and the
+    // offset between their bounding boxes
+    std::array<int, 4> canonical;
+    std::array<Coord, 4> canonicalOffset;
+    for (int r = 0; r < 4; r++) {
+      auto origin = maskOrigin(shape.rotations[r]);
+      canonical[r] = r;
+      canonicalOffset[r] = {0, 0};
+      for (int other = 0; other < r; other++) {
+        auto otherOrigin = maskOrigin(shape.rotations[other]);
+        if (shape.rotations[r] >> (origin.y * PIECE_MASK_SIZE + origin.x) ==
+            shape.rotations[other] >>
+                (otherOrigin.y * PIECE_MASK_SIZE + otherOrigin.x)) {
+          canonical[r] = other;
+          canonicalOffset[r] = {origin.x - otherOrigin.x,
+                                origin.y - otherOrigin.y};
+          break;
+        }
+      }
+    }
+
+    visited.reset();
+    landed.reset();
+    int head = 0;
+    int tail = 0;
+    int found = 0;
+
+    auto visit = [&](State from, Move move, Coord to, int rotationIndex) {
+      auto state = stateOf(to, rotationIndex);
+      if (visited[state]) {
+        return;
+      }
+      visited[state] = true;
+      parents[state] = from;
+      moves[state] = move;
+      queue[tail++] = state;
+    };
+
+    // Where rotating tries the shape, the same as rotatedLocation: in place
+    // first, then each of its kicks
+    auto rotate = [&](Coord at, int rotationIndex,
+                      Rotation rotation) -> std::optional<Coord> {
+      if (fit(at, rotationIndex)) {
+        return at;
+      } else if (shape.kickData == nullptr) {
+        return std::nullopt;
+      }
+      for (auto kick : (*shape.kickData)[rotationIndex]) {
+        auto kicked = Shape::applyKickRotation(kick, rotation) + at;
+        if (fit(kicked, rotationIndex)) {
+          return kicked;
+        }
+      }
+      return std::nullopt;
+    };
+
+    auto start = stateOf(location, shape.rotationIndex);
+    visit(start, Move::START, location, shape.rotationIndex);
+
+    while (head < tail) {
+      auto state = queue[head++];
+      auto [at, rotationIndex] = placementOf(state);
+
+      if (fit({at.x, at.y - 1}, rotationIndex)) {
+        visit(state, Move::DROP, {at.x, at.y - 1}, rotationIndex);
+      } else {
+        auto &offset = canonicalOffset[rotationIndex];
+        auto key = stateOf(at + offset, canonical[rotationIndex]);
+        if (not landed[key]) {
+          landed[key] = true;
+          placements[found++] = {at, rotationIndex};
+        }
+      }
+
+      // Shifting stays on the same row of `fits`
+      auto row = fits[rotationIndex][at.y + PIECE_MASK_SIZE];
+      auto x = at.x + PIECE_MASK_SIZE;
+      if (x > 0 and (row >> (x - 1)) & 1) {
+        visit(state, Move::LEFT, at + Direction::LEFT, rotationIndex);
+      }
+      if ((row >> (x + 1)) & 1) {
+        visit(state, Move::RIGHT, at + Direction::RIGHT, rotationIndex);
+      }
+
+      for (auto [rotation, move, turn] :
+           {std::tuple{Rotation::CLOCKWISE, Move::CLOCKWISE, 1},
+            std::tuple{Rotation::COUNTER_CLOCKWISE, Move::COUNTER_CLOCKWISE,
+                       3}}) {
+        auto rotated = (rotationIndex + turn) % 4;
+        if (auto to = rotate(at, rotated, rotation)) {
+          visit(state, move, *to, rotated);
+        }
+      }
+    }
+
+    return std::span(placements).first(found);
+  }
+
+  template <ShapeFactory Factory>
+  std::span<const Placement> generate(const Tetris<Factory> &tetris) {
+    return generate(tetris.getBoard(), tetris.getCurrentShape(),
+                    tetris.getShapeLocation());
+  }
+
+  // Appends the inputs that take the shape from where the last search started
+  // to `placement` and lock it there
+  // `placement` must have come from the last call to generate
+  void inputsFor(const Placement &placement, std::vector<Input> &out) const {
+    auto first = out.size();
+    for (auto state = stateOf(placement.location, placement.rotationIndex);
+         moves[state] != Move::START; state = parents[state]) {
+      switch (moves[state]) {
+      case Move::LEFT:
+        out.push_back(Direction::LEFT);
+        break;
+      case Move::RIGHT:
+        out.push_back(Direction::RIGHT);
+        break;
+      case Move::CLOCKWISE:
+        out.push_back(Rotation::CLOCKWISE);
+        break;
+      case Move::COUNTER_CLOCKWISE:
+        out.push_back(Rotation::COUNTER_CLOCKWISE);
+        break;
+      case Move::DROP: {
+        auto rows = placementOf(parents[state]).location.y -
+                    placementOf(state).location.y;
+        out.insert(out.end(), rows, Direction::DOWN);
+        break;
+      }
+      default:
+        std::unreachable();
+      }
+    }
+    std::reverse(out.begin() + first, out.end());
+    out.push_back(Key::SPACE);
+  }
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "farm.hpp"
+#include "planner.hpp"
+
+// Plans moves like Planner, but splits the search up by root move: each move
+// the current shape can make is searched on its own across a thread pool, with
+// the planners sharing one transposition table so that lines that meet up are
+// only searched once
+//
+// Each root move is searched with its own beam, so more of the tree is covered
+// than by a single beam of the same width -- in return for the extra cores
+class ParallelPlanner {
+private:
+  WorkStealingPool &pool;
+  TranspositionTable table;
+  // One for each worker in the pool
+  std::vector<std::unique_ptr<Planner>> planners;
+
+  std::vector<PlannedMove> moves;
+  std::vector<Planner::Node> nodes;
+  std::vector<std::optional<Planner::RootValue>> values;
+  std::vector<int> depths;
+  SearchStats searchStats;
+
+public:
+  explicit ParallelPlanner(WorkStealingPool &_pool,
+                           EvaluationWeights weights = {}, int tableBits = 20)
+      : pool(_pool), table(tableBits) {
+    for (unsigned i = 0; i < pool.size(); i++) {
+      planners.push_back(std::make_unique<Planner>(table, weights));
+    }
+  }
+
+  // `depthReached` is the depth every root move was searched to
+  const SearchStats &stats() const { return searchStats; }
+
+  std::optional<PlannedMove> plan(const Board &board,
+                                  std::span<const Shape> queue,
+                                  const std::optional<Shape> &hold,
+                                  bool canHold, Coord location,
+                                  const SearchLimits &limits) {
+    auto start = Planner::Clock::now();
+    Planner::Budget budget{limits, start};
+    searchStats = {};
+    table.newSearch();
+
+    planners[0]->rootMoves(board, queue, hold, canHold, location, budget,
+                           moves, nodes);
+    values.assign(moves.size(), std::nullopt);
+    depths.assign(moves.size(), 0);
+
+    pool.parallelFor((int)nodes.size(), [&](int task, unsigned worker) {
+      auto &planner = *planners[worker];
+      values[task] = planner.searchFrom(nodes[task], queue, limits, budget);
+      depths[task] = planner.stats().depthReached;
+    });
+
+    // Roots searched deeper come first, as a shallow line's value is only
+    // higher for not having looked as far ahead, and roots whose lines all
+    // died out are only played if nothing else can be
+    std::optional<PlannedMove> best;
+    int bestDepth = -1;
+    for (int i = 0; i < (int)moves.size(); i++) {
+      auto value = values[i].value_or(
+          Planner::RootValue{0, std::numeric_limits<float>::lowest()});
+      if (value.depth > bestDepth or
+          (value.depth == bestDepth and value.value > best->value)) {
+        best = moves[i];
+        best->value = value.value;
+        bestDepth = value.depth;
+      }
+    }
+
+    searchStats.nodes = budget.nodes.load();
+    searchStats.depthReached =
+        depths.empty() ? 0 : *std::ranges::min_element(depths);
+    searchStats.elapsed = Planner::Clock::now() - start;
+    return best;
+  }
+
+  template <ShapeFactory Factory>
+  std::optional<PlannedMove> plan(const Tetris<Factory> &tetris,
+                                  const SearchLimits &limits) {
+    std::array<Shape, Tetris<Factory>::MAX_PREVIEW + 1> queue;
+    queue[0] = tetris.getCurrentShape();
+    for (int i = 0; i < tetris.getPreviewSize(); i++) {
+      queue[i + 1] = tetris.getPreview(i);
+    }
+
+    return plan(tetris.getBoard(),
+                std::span(queue).first(tetris.getPreviewSize() + 1),
+                tetris.getHoldShape(), tetris.canHold(),
+                tetris.getShapeLocation(), limits);
+  }
+
+  // Appends the inputs that play `move` in the game it was planned for
+  template <ShapeFactory Factory>
+  void inputsFor(const Tetris<Factory> &tetris, const PlannedMove &move,
+                 std::vector<Input> &out) {
+    planners[0]->inputsFor(tetris, move, out);
+  }
+};
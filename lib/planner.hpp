@@ -0,0 +1,461 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "evaluate.hpp"
+#include "movegen.hpp"
+
+// How much work a search is allowed to do before it has to answer
+struct SearchLimits {
+  // How many shapes ahead to look, counting the current one
+  int depth{3};
+  // How many of the best states to keep searching from at each depth
+  int beamWidth{64};
+  std::int64_t nodes{std::numeric_limits<std::int64_t>::max()};
+  std::chrono::nanoseconds time{std::chrono::nanoseconds::max()};
+};
+
+struct SearchStats {
+  // Placements evaluated
+  std::int64_t nodes{0};
+  std::chrono::nanoseconds elapsed{0};
+  // How many shapes ahead were fully searched
+  int depthReached{0};
+
+  double nodesPerSecond() const {
+    auto seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? (double)nodes / seconds : 0;
+  }
+};
+
+// What to do with the current shape: whether to hold first, and where to put
+// the shape that's then being played
+struct PlannedMove {
+  bool hold;
+  Placement placement;
+  // How good the best line of play following this move looked
+  float value;
+};
+
+// Remembers the best value each state has been reached with, so that the same
+// board reached through different moves is only searched once
+//
+// Searches running at once can share a table without locking: each entry
+// stores its key XORed with its data, so an entry torn by two threads writing
+// it at once just doesn't match anything, and is no worse than a miss
+//
+// Each entry also records which of the searches sharing the table wrote it,
+// as its owner. A search only drops states it has already reached itself --
+// one that meets a line of another search's carries on with it, as otherwise
+// the search that got there first would take the line from the other
+class TranspositionTable {
+private:
+  struct alignas(16) Entry {
+    std::atomic<std::uint64_t> check{0};
+    // The value's bits, then the depth, the owner, and the search it's from,
+    // so tables don't need clearing between searches
+    std::atomic<std::uint64_t> data{0};
+  };
+
+  // The parts of an entry's data that have to match for it to be a hit, and
+  // the owner
+  constexpr static std::uint64_t SAME_STATE = 0xff0000ff00000000;
+  constexpr static std::uint64_t OWNER = 0x00ffff0000000000;
+
+  std::vector<Entry> entries;
+  std::uint8_t generation{0};
+
+  std::uint64_t pack(int depth, std::uint16_t owner, float value) const {
+    return std::bit_cast<std::uint32_t>(value) |
+           (std::uint64_t)(std::uint8_t)depth << 32 |
+           (std::uint64_t)owner << 40 | (std::uint64_t)generation << 56;
+  }
+
+public:
+  explicit TranspositionTable(int bits) : entries(std::size_t{1} << bits) {}
+
+  // Must not be called while a search is using the table
+  void newSearch() {
+    if (++generation == 0) {
+      for (auto &entry : entries) {
+        entry.check.store(0, std::memory_order_relaxed);
+        entry.data.store(0, std::memory_order_relaxed);
+      }
+      generation = 1;
+    }
+  }
+
+  // Records that `key` was reached at `depth` with `value` by the search
+  // `owner`, returning the value to search on from it with, if it's worth
+  // searching -- it isn't if `owner` has already reached it at that depth
+  // with at least as good a value. If another search has, it's the value
+  // that search reached it with
+  std::optional<float> admit(std::uint64_t key, int depth, float value,
+                             std::uint16_t owner = 0) {
+    auto &entry = entries[key & (entries.size() - 1)];
+    auto check = entry.check.load(std::memory_order_relaxed);
+    auto data = entry.data.load(std::memory_order_relaxed);
+    auto packed = pack(depth, owner, value);
+    auto stored = std::bit_cast<float>((std::uint32_t)data);
+    if ((check ^ data) == key and
+        (data & SAME_STATE) == (packed & SAME_STATE) and stored >= value) {
+      if ((data & OWNER) == (packed & OWNER)) {
+        return std::nullopt;
+      }
+      return stored;
+    }
+    entry.data.store(packed, std::memory_order_relaxed);
+    entry.check.store(key ^ packed, std::memory_order_relaxed);
+    return value;
+  }
+};
+
+// Plans moves by searching several shapes deep -- the current shape, the held
+// one and the preview -- keeping only the best states at each depth
+class Planner {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // A state partway through a line of play
+  struct Node {
+    Board board;
+    std::optional<Shape> hold;
+    // Index of the next shape to play from the queue
+    int next;
+    // Value of the lines cleared on the way to this state
+    float reward;
+    float value;
+    // Which of the moves from the root this line of play started with
+    int root;
+  };
+
+  // How far a search from a root move got, and the value of its best line
+  struct RootValue {
+    int depth;
+    float value;
+  };
+
+  // How much a search can still spend, which can be shared by searches
+  // running at once
+  struct Budget {
+    Clock::time_point deadline;
+    std::int64_t maxNodes;
+    std::atomic<std::int64_t> nodes{0};
+
+    explicit Budget(const SearchLimits &limits,
+                    Clock::time_point start = Clock::now())
+        : deadline(limits.time >= Clock::time_point::max() - start
+                       ? Clock::time_point::max()
+                       : start + limits.time),
+          maxNodes(limits.nodes) {}
+
+    bool spent() const {
+      return nodes.load(std::memory_order_relaxed) >= maxNodes or
+             Clock::now() >= deadline;
+    }
+  };
+
+private:
+  // A state that might make it into the next beam, kept light until it does
+  struct Candidate {
+    int parent;
+    bool held;
+    Placement placement;
+    float reward;
+    float value;
+    int root;
+  };
+
+  // The shape that's played from a node, what's held afterwards, and where in
+  // the queue the line of play continues -- for each of playing the next shape,
+  // swapping with the held one, and holding into an empty slot
+  struct Option {
+    bool held;
+    Shape shape;
+    std::optional<Shape> hold;
+    int next;
+  };
+
+  EvaluationWeights weights;
+  std::unique_ptr<TranspositionTable> ownTable;
+  TranspositionTable *table;
+  std::unique_ptr<MoveGenerator> generator = std::make_unique<MoveGenerator>();
+  std::vector<Node> beam;
+  std::vector<Node> nextBeam;
+  std::vector<Candidate> candidates;
+  std::vector<PlannedMove> roots;
+  SearchStats searchStats;
+  // Which search this is of those sharing the table
+  std::uint16_t owner{0};
+
+  static std::uint64_t mix(std::uint64_t x) { return splitMix64(x); }
+
+  static std::uint64_t shapeHash(const std::optional<Shape> &shape) {
+    if (not shape) {
+      return 0;
+    }
+    std::uint64_t rotations = 0;
+    for (auto mask : shape->rotations) {
+      rotations = (rotations << 16) | mask;
+    }
+    return mix(rotations ^ (std::uint64_t)shape->rotationIndex);
+  }
+
+  static int options(const Node &node, std::span<const Shape> queue,
+                     bool canHold, std::array<Option, 2> &out) {
+    int count = 0;
+    out[count++] = {false, queue[node.next], node.hold, node.next + 1};
+    if (not canHold) {
+      return count;
+    }
+    if (node.hold) {
+      out[count++] = {true, *node.hold, queue[node.next], node.next + 1};
+    } else if (node.next + 1 < (int)queue.size()) {
+      out[count++] = {true, queue[node.next + 1], queue[node.next],
+                      node.next + 2};
+    }
+    return count;
+  }
+
+  // Evaluates every move from every node in the beam, `depth` shapes into the
+  // line of play, into `candidates`
+  // Returns false if the budget ran out before the whole beam was expanded
+  bool expand(std::span<const Shape> queue, bool canHold, Coord location,
+              int depth, Budget &budget) {
+    candidates.clear();
+    for (int parent = 0; parent < (int)beam.size(); parent++) {
+      auto &node = beam[parent];
+      if (node.next >= (int)queue.size()) {
+        continue;
+      }
+
+      std::int64_t nodes = 0;
+      std::array<Option, 2> choices;
+      int count = options(node, queue, depth > 0 or canHold, choices);
+      for (auto &option : std::span(choices).first(count)) {
+        // The shape in play at the root might have already been moved
+        auto from = depth == 0 and not option.held
+                        ? location
+                        : spawnLocation(node.board, option.shape);
+
+        for (auto &placement :
+             generator->generate(node.board, option.shape, from)) {
+          auto shape = option.shape;
+          shape.rotationIndex = placement.rotationIndex;
+          auto after = node.board;
+          after.place(shape.mask(), placement.location.x,
+                      placement.location.y);
+          int lines = after.clearRows(placement.location.y, shape.size);
+
+          auto reward = node.reward + weights.linesCleared * (float)lines;
+          nodes++;
+
+          auto key = after.hash() ^
+                     mix(shapeHash(option.hold) + (std::uint64_t)option.next);
+          auto value = table->admit(
+              key, depth, reward + BoardEvaluator::score(after, 0, weights),
+              owner);
+          if (not value) {
+            continue;
+          }
+
+          int root = node.root;
+          if (depth == 0) {
+            root = (int)roots.size();
+            roots.push_back({option.held, placement, *value});
+          }
+          candidates.push_back(
+              {parent, option.held, placement, reward, *value, root});
+        }
+      }
+
+      searchStats.nodes += nodes;
+      budget.nodes.fetch_add(nodes, std::memory_order_relaxed);
+      if (budget.spent()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Replaces the beam with the states of the candidates
+  void advance(std::span<const Shape> queue, bool canHold, int depth) {
+    nextBeam.clear();
+    for (auto &candidate : candidates) {
+      auto &parent = beam[candidate.parent];
+      std::array<Option, 2> choices;
+      options(parent, queue, depth > 0 or canHold, choices);
+      auto &option = choices[candidate.held ? 1 : 0];
+
+      auto shape = option.shape;
+      shape.rotationIndex = candidate.placement.rotationIndex;
+      auto after = parent.board;
+      after.place(shape.mask(), candidate.placement.location.x,
+                  candidate.placement.location.y);
+      after.clearRows(candidate.placement.location.y, shape.size);
+      nextBeam.push_back({after, option.hold, option.next, candidate.reward,
+                          candidate.value, candidate.root});
+    }
+    std::swap(beam, nextBeam);
+  }
+
+  // Searches from the beam, starting `firstDepth` shapes into the line of play
+  // and stopping before `lastDepth`, returning the best candidate from the
+  // deepest level reached
+  std::optional<Candidate> search(std::span<const Shape> queue, bool canHold,
+                                  Coord location, int firstDepth,
+                                  int lastDepth, int beamWidth,
+                                  Budget &budget) {
+    std::optional<Candidate> best;
+    lastDepth = std::min(lastDepth, (int)queue.size());
+    for (int d = firstDepth; d < lastDepth and not beam.empty(); d++) {
+      bool finished = expand(queue, canHold, location, d, budget);
+
+      // Keep the best of this depth
+      auto keep = std::min((int)candidates.size(), beamWidth);
+      std::ranges::partial_sort(
+          candidates, candidates.begin() + keep,
+          [](auto &a, auto &b) { return a.value > b.value; });
+      candidates.resize(keep);
+
+      if (not candidates.empty()) {
+        best = candidates.front();
+      }
+      if (not finished) {
+        break;
+      }
+      searchStats.depthReached = d + 1;
+      advance(queue, canHold, d);
+    }
+    return best;
+  }
+
+public:
+  explicit Planner(EvaluationWeights _weights = {}, int tableBits = 16)
+      : weights(_weights),
+        ownTable(std::make_unique<TranspositionTable>(tableBits)),
+        table(ownTable.get()) {}
+
+  // A planner that shares `sharedTable` with other planners
+  explicit Planner(TranspositionTable &sharedTable,
+                   EvaluationWeights _weights = {})
+      : weights(_weights), table(&sharedTable) {}
+
+  const SearchStats &stats() const { return searchStats; }
+
+  // Searches from a board, with the shapes still to come (the first being the
+  // one currently in play, at `location`) and what's in hold
+  std::optional<PlannedMove> plan(const Board &board,
+                                  std::span<const Shape> queue,
+                                  const std::optional<Shape> &hold,
+                                  bool canHold, Coord location,
+                                  const SearchLimits &limits) {
+    auto start = Clock::now();
+    Budget budget{limits, start};
+    searchStats = {};
+    owner = 0;
+    table->newSearch();
+    roots.clear();
+    beam.clear();
+    beam.push_back({board, hold, 0, 0, 0, -1});
+
+    auto best = search(queue, canHold, location, 0, limits.depth,
+                       limits.beamWidth, budget);
+    searchStats.elapsed = Clock::now() - start;
+    if (not best) {
+      return std::nullopt;
+    }
+    auto move = roots[best->root];
+    move.value = best->value;
+    return move;
+  }
+
+  template <ShapeFactory Factory>
+  std::optional<PlannedMove> plan(const Tetris<Factory> &tetris,
+                                  const SearchLimits &limits) {
+    std::array<Shape, Tetris<Factory>::MAX_PREVIEW + 1> queue;
+    queue[0] = tetris.getCurrentShape();
+    for (int i = 0; i < tetris.getPreviewSize(); i++) {
+      queue[i + 1] = tetris.getPreview(i);
+    }
+
+    return plan(tetris.getBoard(),
+                std::span(queue).first(tetris.getPreviewSize() + 1),
+                tetris.getHoldShape(), tetris.canHold(),
+                tetris.getShapeLocation(), limits);
+  }
+
+  // The first step of a search split up by root move: every move that can be
+  // made from the root, and the state each one leads to (with `root` indexing
+  // the moves)
+  // Doesn't start a new search of the table
+  void rootMoves(const Board &board, std::span<const Shape> queue,
+                 const std::optional<Shape> &hold, bool canHold,
+                 Coord location, Budget &budget,
+                 std::vector<PlannedMove> &moves, std::vector<Node> &nodes) {
+    searchStats = {};
+    owner = 0;
+    roots.clear();
+    beam.clear();
+    beam.push_back({board, hold, 0, 0, 0, -1});
+    if (not queue.empty()) {
+      expand(queue, canHold, location, 0, budget);
+      advance(queue, canHold, 0);
+    }
+    moves.assign(roots.begin(), roots.end());
+    nodes.assign(beam.begin(), beam.end());
+  }
+
+  // Searches on from a state one of rootMoves led to, up to `limits.depth`
+  // shapes into the line of play, returning the value of the best line at the
+  // deepest depth searched in full, and that depth
+  // Values from different depths can't be compared, as shallower lines haven't
+  // run into the trouble deeper ones have
+  // Returns nothing if every line from the state was a dead end
+  std::optional<RootValue> searchFrom(const Node &node,
+                                      std::span<const Shape> queue,
+                                      const SearchLimits &limits,
+                                      Budget &budget) {
+    searchStats = {};
+    searchStats.depthReached = 1;
+    // Other searches from the root moves can carry on the lines this one
+    // meets, and this one theirs
+    owner = (std::uint16_t)(node.root + 1);
+    if (std::min(limits.depth, (int)queue.size()) <= 1 or budget.spent()) {
+      return RootValue{1, node.value};
+    }
+    beam.clear();
+    beam.push_back(node);
+    search(queue, true, {}, 1, limits.depth, limits.beamWidth, budget);
+    // The beam is left as the deepest depth searched in full, best first
+    if (beam.empty()) {
+      return std::nullopt;
+    }
+    return RootValue{searchStats.depthReached, beam.front().value};
+  }
+
+  // Appends the inputs that play `move` in the game it was planned for
+  template <ShapeFactory Factory>
+  void inputsFor(const Tetris<Factory> &tetris, const PlannedMove &move,
+                 std::vector<Input> &out) {
+    auto shape = tetris.getCurrentShape();
+    auto location = tetris.getShapeLocation();
+    if (move.hold) {
+      out.push_back(Key::HOLD);
+      shape = tetris.getHoldShape().value_or(tetris.getPreview(0));
+      location = spawnLocation(tetris.getBoard(), shape);
+    }
+
+    generator->generate(tetris.getBoard(), shape, location);
+    generator->inputsFor(move.placement, out);
+  }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// SplitMix64, for turning a single seed into well-mixed values
+constexpr std::uint64_t splitMix64(std::uint64_t &state) {
+  std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+// xoshiro256** -- a small, fast generator whose whole state lives inline, so
+// every game can cheaply carry its own
+class Xoshiro256 {
+private:
+  std::uint64_t s[4];
+
+  constexpr static std::uint64_t rotl(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+public:
+  constexpr explicit Xoshiro256(std::uint64_t seed) : s{} {
+    for (auto &word : s) {
+      word = splitMix64(seed);
+    }
+  }
+
+  constexpr std::uint64_t operator()() {
+    auto result = rotl(s[1] * 5, 7) * 9;
+    auto t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+  }
+
+  // A value in [0, bound), using the top bits of the output
+  constexpr std::uint32_t below(std::uint32_t bound) {
+    return (std::uint32_t)(((*this)() >> 32) * bound >> 32);
+  }
+};
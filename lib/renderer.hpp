@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "tetris.hpp"
+
+// Draws a game on an ANSI terminal a frame at a time. Each frame is built in a
+// buffer that's reused from frame to frame, and only the rows that have
+// changed since the last frame are redrawn, so an unchanged frame costs
+// nothing and a typical one a few hundred bytes, sent in a single write
+//
+// The board is compared as bit rows, with the shape in play drawn in, so
+// finding what's changed doesn't build any strings either
+class TerminalRenderer {
+public:
+  // Number of rows (from the bottom of the board) that are drawn
+  constexpr static int VISIBLE_ROWS = 20;
+
+private:
+  // Moving the cursor takes at most "\x1b[RR;CCH", and then every cell is two
+  // characters, between the walls
+  constexpr static std::size_t ROW_BYTES = 8 + 2 * Board::MAX_WIDTH + 2;
+  // Enough for clearing the screen, every row, the floor and the status line
+  constexpr static std::size_t CAPACITY =
+      16 + (VISIBLE_ROWS + 1) * ROW_BYTES + 128;
+
+  struct Status {
+    int score{0};
+    int lines{0};
+    int level{0};
+    GameStatus status{GameStatus::PLAYING};
+
+    bool operator==(const Status &other) const = default;
+  };
+
+  std::array<char, CAPACITY> buffer;
+  std::size_t length{0};
+
+  // What's on the screen, if it's been drawn since it was last invalidated
+  bool drawn{false};
+  int width{0};
+  std::array<Board::Row, VISIBLE_ROWS> shown{};
+  Status shownStatus{};
+
+  void put(std::string_view text) {
+    for (auto c : text) {
+      buffer[length++] = c;
+    }
+  }
+
+  void putInt(int value) {
+    auto result =
+        std::to_chars(buffer.data() + length, buffer.data() + CAPACITY, value);
+    length = result.ptr - buffer.data();
+  }
+
+  // Rows and columns count from 1 at the top left
+  void moveTo(int row, int column) {
+    put("\x1b[");
+    putInt(row);
+    put(";");
+    putInt(column);
+    put("H");
+  }
+
+  void putRow(int screenRow, Board::Row row) {
+    moveTo(screenRow, 1);
+    put("|");
+    for (int x = 0; x < width; x++) {
+      put((row >> x) & 1 ? "[]" : " .");
+    }
+    put("|");
+  }
+
+  // The visible rows of the board with the shape in play drawn in
+  template <ShapeFactory Factory>
+  static std::array<Board::Row, VISIBLE_ROWS>
+  compose(const Tetris<Factory> &tetris) {
+    std::array<Board::Row, VISIBLE_ROWS> rows{};
+    auto &board = tetris.getBoard();
+    for (int y = 0; y < VISIBLE_ROWS and y < board.getHeight(); y++) {
+      rows[y] = board.rowAt(y);
+    }
+
+    auto location = tetris.getShapeLocation();
+    auto mask = tetris.getCurrentShape().mask();
+    for (int r = 0; r < PIECE_MASK_SIZE; r++) {
+      int y = location.y + r;
+      unsigned cells = pieceRow(mask, r);
+      if (cells == 0 or y < 0 or y >= VISIBLE_ROWS) {
+        continue;
+      }
+      cells = location.x >= 0 ? cells << location.x : cells >> -location.x;
+      rows[y] |= static_cast<Board::Row>(cells);
+    }
+    return rows;
+  }
+
+public:
+  // Forgets what's on the screen, so the next frame is drawn in full
+  void invalidate() { drawn = false; }
+
+  // Builds what needs sending to the terminal to bring it up to date with
+  // `tetris`, which is only valid until the next frame is rendered
+  template <ShapeFactory Factory>
+  std::string_view render(const Tetris<Factory> &tetris) {
+    length = 0;
+    if (tetris.width != width) {
+      width = tetris.width;
+      drawn = false;
+    }
+
+    auto rows = compose(tetris);
+    Status status{tetris.getScore(), tetris.getLines(), tetris.getLevel(),
+                  tetris.getStatus()};
+    if (not drawn) {
+      put("\x1b[2J");
+      moveTo(VISIBLE_ROWS + 1, 1);
+      put("+");
+      for (int x = 0; x < width; x++) {
+        put("--");
+      }
+      put("+");
+    }
+
+    for (int y = 0; y < VISIBLE_ROWS; y++) {
+      if (not drawn or rows[y] != shown[y]) {
+        putRow(VISIBLE_ROWS - y, rows[y]);
+      }
+    }
+
+    if (not drawn or status != shownStatus) {
+      moveTo(VISIBLE_ROWS + 2, 1);
+      put("Score ");
+      putInt(status.score);
+      put("  Lines ");
+      putInt(status.lines);
+      put("  Level ");
+      putInt(status.level);
+      if (status.status != GameStatus::PLAYING) {
+        put("  GAME OVER");
+      }
+      // Clear whatever's left of a longer line from before
+      put("\x1b[K");
+    }
+
+    shown = rows;
+    shownStatus = status;
+    drawn = true;
+    return {buffer.data(), length};
+  }
+
+  // Renders a frame and writes it to `fd` in one go, if anything's changed
+  // Returns whether it was all written
+  template <ShapeFactory Factory>
+  bool draw(const Tetris<Factory> &tetris, int fd = STDOUT_FILENO) {
+    auto frame = render(tetris);
+    while (not frame.empty()) {
+      auto written = ::write(fd, frame.data(), frame.size());
+      if (written < 0 and errno == EINTR) {
+        continue;
+      } else if (written <= 0) {
+        // Whatever's on the screen now is unknown
+        invalidate();
+        return false;
+      }
+      frame.remove_prefix(written);
+    }
+    return true;
+  }
+};
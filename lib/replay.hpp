@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+
+#include "tetris.hpp"
+
+// A recorded game is a header -- everything needed to start the same game
+// again -- then a stream of events, each packed into a LEB128 varint of
+//
+//   (frames since the previous event << 3) | input code
+//
+// so inputs less than 16 frames apart take a single byte. An event with the
+// END code finishes the stream
+
+// What's needed to start a recorded game again
+struct ReplayHeader {
+  // Seed for the game's shape factory
+  std::uint64_t seed{0};
+  int width{10};
+  int height{40};
+  int previewSize{5};
+
+  auto operator<=>(const ReplayHeader &other) const = default;
+};
+
+// An input, and the frame it was played on
+struct ReplayEvent {
+  std::uint64_t frame;
+  Input input;
+
+  bool operator==(const ReplayEvent &other) const = default;
+};
+
+enum class ReplayError { BAD_MAGIC, BAD_VERSION, TRUNCATED, BAD_EVENT };
+
+struct ReplayFormat {
+  constexpr static std::array<std::uint8_t, 4> MAGIC{'T', 'R', 'P', 'L'};
+  constexpr static std::uint8_t VERSION = 1;
+
+  constexpr static int CODE_BITS = 3;
+  // Code for the event that ends a stream
+  constexpr static std::uint8_t END = 7;
+
+  static std::uint8_t inputCode(Input input) {
+    return std::visit(
+        overloaded{
+            [](Direction direction) -> std::uint8_t {
+              return (std::uint8_t)direction;
+            },
+            [](Key key) -> std::uint8_t { return 3 + (std::uint8_t)key; },
+            [](Rotation rotation) -> std::uint8_t {
+              return 5 + (std::uint8_t)rotation;
+            }},
+        input);
+  }
+
+  static std::optional<Input> codeInput(std::uint8_t code) {
+    switch (code) {
+    case 0:
+    case 1:
+    case 2:
+      return Direction(code);
+    case 3:
+    case 4:
+      return Key(code - 3);
+    case 5:
+    case 6:
+      return Rotation(code - 5);
+    default:
+      return std::nullopt;
+    }
+  }
+
+  // Appends `value` as a LEB128 varint: 7 bits a byte, lowest first, with the
+  // top bit set on every byte but the last
+  template <typename Put>
+  static void writeVarint(std::uint64_t value, Put put) {
+    while (value >= 0x80) {
+      put((std::uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    put((std::uint8_t)value);
+  }
+
+  // Reads a varint starting at `bytes[pos]`, moving `pos` past it
+  static std::optional<std::uint64_t>
+  readVarint(std::span<const std::uint8_t> bytes, std::size_t &pos) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64 and pos < bytes.size(); shift += 7) {
+      auto byte = bytes[pos++];
+      value |= (std::uint64_t)(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+// Records a game as it's played, writing each event out as soon as it's
+// recorded
+class ReplayWriter {
+private:
+  std::ostream &out;
+  std::uint64_t lastFrame{0};
+  bool finished = false;
+
+  void put(std::uint8_t byte) { out.put((char)byte); }
+
+  void event(std::uint64_t delta, std::uint8_t code) {
+    ReplayFormat::writeVarint(delta << ReplayFormat::CODE_BITS | code,
+                              [this](auto byte) { put(byte); });
+  }
+
+public:
+  ReplayWriter(std::ostream &_out, const ReplayHeader &header) : out(_out) {
+    for (auto byte : ReplayFormat::MAGIC) {
+      put(byte);
+    }
+    put(ReplayFormat::VERSION);
+    auto putByte = [this](auto byte) { put(byte); };
+    ReplayFormat::writeVarint(header.seed, putByte);
+    ReplayFormat::writeVarint((std::uint64_t)header.width, putByte);
+    ReplayFormat::writeVarint((std::uint64_t)header.height, putByte);
+    ReplayFormat::writeVarint((std::uint64_t)header.previewSize, putByte);
+  }
+
+  ReplayWriter(const ReplayWriter &) = delete;
+  ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+  ~ReplayWriter() { finish(); }
+
+  // Frames must be recorded in order
+  void record(std::uint64_t frame, Input input) {
+    if (finished) {
+      throw std::logic_error("can't record to a finished replay");
+    }
+    if (frame < lastFrame) {
+      throw std::invalid_argument(
+          std::format("frame {} is before the last recorded frame {}", frame,
+                      lastFrame));
+    }
+    event(frame - lastFrame, ReplayFormat::inputCode(input));
+    lastFrame = frame;
+  }
+
+  // Ends the stream -- nothing can be recorded after
+  void finish() {
+    if (not finished) {
+      event(0, ReplayFormat::END);
+      finished = true;
+    }
+  }
+};
+
+// Reads a recorded game back out of a buffer
+class ReplayReader {
+private:
+  std::span<const std::uint8_t> bytes;
+  std::size_t pos{0};
+  ReplayHeader header;
+  std::uint64_t frame{0};
+  bool ended = false;
+
+  explicit ReplayReader(std::span<const std::uint8_t> _bytes)
+      : bytes(_bytes) {}
+
+public:
+  // Reads the header of the replay at the start of `bytes`
+  static std::expected<ReplayReader, ReplayError>
+  open(std::span<const std::uint8_t> bytes) {
+    ReplayReader reader{bytes};
+    if (bytes.size() < ReplayFormat::MAGIC.size() + 1) {
+      return std::unexpected(ReplayError::TRUNCATED);
+    }
+    if (not std::ranges::equal(bytes.first(ReplayFormat::MAGIC.size()),
+                               ReplayFormat::MAGIC)) {
+      return std::unexpected(ReplayError::BAD_MAGIC);
+    }
+    reader.pos = ReplayFormat::MAGIC.size();
+    if (bytes[reader.pos++] != ReplayFormat::VERSION) {
+      return std::unexpected(ReplayError::BAD_VERSION);
+    }
+
+    std::array<std::uint64_t, 4> fields;
+    for (auto &field : fields) {
+      auto value = ReplayFormat::readVarint(bytes, reader.pos);
+      if (not value) {
+        return std::unexpected(ReplayError::TRUNCATED);
+      }
+      field = *value;
+    }
+    reader.header = {fields[0], (int)fields[1], (int)fields[2],
+                     (int)fields[3]};
+    return reader;
+  }
+
+  const ReplayHeader &getHeader() const { return header; }
+
+  // How far into the buffer the reader has got -- once the stream has ended,
+  // this is where anything after it starts
+  std::size_t position() const { return pos; }
+  // The frame of the last event read
+  std::uint64_t getFrame() const { return frame; }
+
+  // Carries on reading from somewhere `position()` and `getFrame()` were
+  // earlier
+  void seek(std::size_t position, std::uint64_t lastFrame) {
+    pos = position;
+    frame = lastFrame;
+    ended = false;
+  }
+
+  // The next event, or nothing once the stream has ended
+  std::expected<std::optional<ReplayEvent>, ReplayError> next() {
+    if (ended) {
+      return std::nullopt;
+    }
+    auto value = ReplayFormat::readVarint(bytes, pos);
+    if (not value) {
+      return std::unexpected(ReplayError::TRUNCATED);
+    }
+
+    auto code = (std::uint8_t)(*value & ((1 << ReplayFormat::CODE_BITS) - 1));
+    if (code == ReplayFormat::END) {
+      ended = true;
+      return std::nullopt;
+    }
+    auto input = ReplayFormat::codeInput(code);
+    if (not input) {
+      return std::unexpected(ReplayError::BAD_EVENT);
+    }
+    frame += *value >> ReplayFormat::CODE_BITS;
+    return ReplayEvent{frame, *input};
+  }
+};
+
+// Starts the game a replay was recorded from, dealing shapes from a factory
+// made from the replay's seed
+template <ShapeFactory Factory>
+  requires std::constructible_from<Factory, std::uint64_t>
+auto startReplay(const ReplayHeader &header) {
+  return Tetris<Factory>::createTetris(header.width, header.height,
+                                       Factory{header.seed},
+                                       header.previewSize);
+}
+
+// Plays the rest of a recorded game's events into `tetris`, which should have
+// been started from the replay's header
+// Returns the number of events played
+template <ShapeFactory Factory>
+std::expected<int, ReplayError> playReplay(ReplayReader &reader,
+                                           Tetris<Factory> &tetris) {
+  int played = 0;
+  while (true) {
+    auto event = reader.next();
+    if (not event) {
+      return std::unexpected(event.error());
+    } else if (not *event) {
+      return played;
+    }
+    tetris.handleInput((*event)->input);
+    played++;
+  }
+}
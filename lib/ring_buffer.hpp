@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// Fixed-capacity FIFO queue stored inline, overwriting nothing -- pushing onto
+// a full buffer is a caller error
+template <typename T, std::size_t Capacity> class RingBuffer {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+private:
+  std::array<T, Capacity> items{};
+  std::size_t head{0};
+  std::size_t count{0};
+
+public:
+  constexpr static std::size_t capacity() { return Capacity; }
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == Capacity; }
+  // Whether the front and size are in range, for checking buffers read in from
+  // outside
+  bool consistent() const { return head < Capacity and count <= Capacity; }
+
+  // The `i`th item from the front of the queue
+  const T &operator[](std::size_t i) const {
+    return items[(head + i) & (Capacity - 1)];
+  }
+  T &operator[](std::size_t i) { return items[(head + i) & (Capacity - 1)]; }
+
+  const T &front() const { return (*this)[0]; }
+  const T &back() const { return (*this)[count - 1]; }
+
+  void push_back(const T &item) {
+    items[(head + count) & (Capacity - 1)] = item;
+    count++;
+  }
+
+  T pop_front() {
+    T item = std::move(items[head]);
+    head = (head + 1) & (Capacity - 1);
+    count--;
+    return item;
+  }
+
+  void pop_back() { count--; }
+
+  void clear() { head = count = 0; }
+};
+
+// Fixed-capacity FIFO queue for handing items from one thread to another
+// without locking: one thread pushes and one thread pops. Pushing onto a full
+// queue drops the item rather than waiting, so the pushing thread never blocks
+template <typename T, std::size_t Capacity> class SpscRingBuffer {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>);
+
+private:
+  // Counts of the items ever pushed and popped, each only written by one side
+  // and kept on its own cache line so the two sides don't contend
+  alignas(64) std::atomic<std::size_t> pushed{0};
+  // The pusher's last look at `popped`, which only needs updating when the
+  // queue seems full
+  std::size_t knownPopped{0};
+  std::atomic<std::uint64_t> droppedCount{0};
+
+  alignas(64) std::atomic<std::size_t> popped{0};
+  // The popper's last look at `pushed`, likewise
+  std::size_t knownPushed{0};
+
+  alignas(64) std::array<T, Capacity> items{};
+
+public:
+  constexpr static std::size_t capacity() { return Capacity; }
+
+  // Only to be called by the pushing thread
+  // Returns whether there was room for the item
+  bool tryPush(const T &item) {
+    auto tail = pushed.load(std::memory_order_relaxed);
+    if (tail - knownPopped == Capacity) {
+      knownPopped = popped.load(std::memory_order_acquire);
+      if (tail - knownPopped == Capacity) {
+        droppedCount.store(droppedCount.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+        return false;
+      }
+    }
+    items[tail & (Capacity - 1)] = item;
+    pushed.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Only to be called by the popping thread
+  std::optional<T> tryPop() {
+    auto head = popped.load(std::memory_order_relaxed);
+    if (head == knownPushed) {
+      knownPushed = pushed.load(std::memory_order_acquire);
+      if (head == knownPushed) {
+        return std::nullopt;
+      }
+    }
+    T item = items[head & (Capacity - 1)];
+    popped.store(head + 1, std::memory_order_release);
+    return item;
+  }
+
+  // Pops everything that's been pushed so far, calling `f(item)` on each in
+  // turn. Only to be called by the popping thread
+  // Returns how many items were popped
+  template <typename F> std::size_t drain(F &&f) {
+    auto head = popped.load(std::memory_order_relaxed);
+    knownPushed = pushed.load(std::memory_order_acquire);
+    for (auto i = head; i != knownPushed; i++) {
+      f(items[i & (Capacity - 1)]);
+    }
+    popped.store(knownPushed, std::memory_order_release);
+    return knownPushed - head;
+  }
+
+  // Number of items dropped so far because the queue was full
+  std::uint64_t dropped() const {
+    return droppedCount.load(std::memory_order_relaxed);
+  }
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <expected>
+#include <span>
+
+#include "ring_buffer.hpp"
+#include "tetris.hpp"
+
+// Runs a game a frame at a time for netcode that predicts inputs it hasn't
+// received yet. A snapshot is kept of the state at the start of each of the
+// last `History` frames, so that when the real inputs for a frame turn up late
+// the game can be rewound to that frame and played forward again
+//
+// Rewinding and resimulating only copy snapshots around, so they never
+// allocate
+template <ShapeFactory Factory, std::size_t History = 64> class Rollback {
+public:
+  // Most inputs that can be played in a single frame
+  constexpr static int MAX_FRAME_INPUTS = 8;
+
+  enum class RollbackError { TOO_MANY_INPUTS, FRAME_TOO_OLD, FRAME_NOT_PLAYED };
+
+private:
+  struct Frame {
+    // The state at the start of the frame, before its inputs
+    GameState<Factory> state;
+    std::array<Input, MAX_FRAME_INPUTS> inputs;
+    int inputCount;
+
+    std::span<const Input> played() const {
+      return std::span(inputs).first(inputCount);
+    }
+  };
+
+  Tetris<Factory> tetris;
+  RingBuffer<Frame, History> frames;
+  // Number of the first frame still in `frames`
+  int oldest{0};
+
+  void play(Frame &frame) {
+    frame.state = tetris.snapshot();
+    for (auto input : frame.played()) {
+      tetris.handleInput(input);
+    }
+  }
+
+public:
+  explicit Rollback(Tetris<Factory> _tetris) : tetris{std::move(_tetris)} {}
+
+  const Tetris<Factory> &getTetris() const { return tetris; }
+
+  // Number of frames played so far, which is also the number of the next one
+  int frame() const { return oldest + (int)frames.size(); }
+  // The oldest frame that can still be corrected
+  int oldestFrame() const { return oldest; }
+
+  // Plays the next frame with `inputs`, which can be a guess to be corrected
+  // later
+  std::expected<void, RollbackError> advance(std::span<const Input> inputs) {
+    if (inputs.size() > MAX_FRAME_INPUTS) {
+      return std::unexpected(RollbackError::TOO_MANY_INPUTS);
+    }
+    if (frames.full()) {
+      frames.pop_front();
+      oldest++;
+    }
+
+    frames.push_back(Frame{});
+    auto &next = frames[frames.size() - 1];
+    std::ranges::copy(inputs, next.inputs.begin());
+    next.inputCount = (int)inputs.size();
+    play(next);
+    return {};
+  }
+
+  // Replaces the inputs played at `frame` with what they really were, then
+  // rewinds to that frame and plays every frame since again
+  // Returns the number of frames played again, which is 0 if the inputs were
+  // right all along
+  std::expected<int, RollbackError> correct(int frame,
+                                            std::span<const Input> inputs) {
+    if (inputs.size() > MAX_FRAME_INPUTS) {
+      return std::unexpected(RollbackError::TOO_MANY_INPUTS);
+    } else if (frame < oldest) {
+      return std::unexpected(RollbackError::FRAME_TOO_OLD);
+    } else if (frame >= this->frame()) {
+      return std::unexpected(RollbackError::FRAME_NOT_PLAYED);
+    }
+
+    auto &corrected = frames[frame - oldest];
+    if (std::ranges::equal(corrected.played(), inputs)) {
+      return 0;
+    }
+    std::ranges::copy(inputs, corrected.inputs.begin());
+    corrected.inputCount = (int)inputs.size();
+
+    tetris.restore(corrected.state);
+    for (int f = frame - oldest; f < (int)frames.size(); f++) {
+      play(frames[f]);
+    }
+    return this->frame() - frame;
+  }
+};
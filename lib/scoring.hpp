@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+#include "board.hpp"
+
+// Scoring from the guideline: points for each lock depend on the rows it
+// cleared and whether it was a T-spin, scaled by the level. Clears in a row
+// build a combo, and difficult clears -- tetrises and T-spins -- in a row are
+// worth half as much again (back-to-back)
+//
+// Everything here looks at a fixed number of cells, so scoring a lock takes
+// the same time however full the board is
+
+enum class Spin : std::uint8_t { NONE, MINI, FULL };
+
+// What locking a shape did, as far as scoring goes
+struct Lock {
+  int lines{0};
+  Spin spin{Spin::NONE};
+
+  constexpr bool operator==(const Lock &other) const = default;
+};
+
+// What carries on from one lock to the next
+struct ScoreChain {
+  // Number of locks in a row that have cleared rows, less one -- so -1 when
+  // the last lock didn't clear any
+  int combo{-1};
+  // Whether the last lock to clear rows was a difficult clear
+  bool backToBack{false};
+};
+
+namespace scoring {
+constexpr int LINES_PER_LEVEL = 10;
+
+// Points for clearing 0 to 4 rows, as a plain clear, a T-spin mini and a
+// T-spin, before they're scaled by the level
+constexpr std::array<int, 5> CLEAR{0, 100, 300, 500, 800};
+constexpr std::array<int, 3> MINI{100, 200, 400};
+constexpr std::array<int, 4> T_SPIN{400, 800, 1200, 1600};
+// Points for each lock in a combo after the first
+constexpr int COMBO = 50;
+// Points for each row a hard drop falls
+constexpr int HARD_DROP = 2;
+
+constexpr int levelFor(int lines) { return 1 + lines / LINES_PER_LEVEL; }
+
+constexpr int points(Lock lock) {
+  switch (lock.spin) {
+  case Spin::NONE:
+    return CLEAR[std::clamp(lock.lines, 0, (int)CLEAR.size() - 1)];
+  case Spin::MINI:
+    return MINI[std::clamp(lock.lines, 0, (int)MINI.size() - 1)];
+  case Spin::FULL:
+    return T_SPIN[std::clamp(lock.lines, 0, (int)T_SPIN.size() - 1)];
+  default:
+    std::unreachable();
+  }
+}
+
+constexpr bool difficult(Lock lock) {
+  return lock.lines >= 4 or (lock.lines > 0 and lock.spin != Spin::NONE);
+}
+
+// Points for `lock` at `level`, moving `chain` on past it
+constexpr int award(ScoreChain &chain, Lock lock, int level) {
+  int score = points(lock);
+  if (lock.lines == 0) {
+    // Locking without clearing ends a combo, but not a back-to-back
+    chain.combo = -1;
+    return score * level;
+  }
+
+  chain.combo++;
+  if (difficult(lock)) {
+    if (chain.backToBack) {
+      score += score / 2;
+    }
+    chain.backToBack = true;
+  } else {
+    chain.backToBack = false;
+  }
+  return (score + COMBO * chain.combo) * level;
+}
+
+// Whether a T, whose cells are `mask` with the bottom-left of its bounding box
+// at (x, y), was spun into place on `board`, by the 3-corner rule: at least
+// three of the four cells diagonal to its centre must be filled or outside
+// the board. It's a full T-spin if both the corners it points at are, and
+// otherwise a mini -- unless it got there by the last of its kicks (a column
+// and two rows), which always makes a full T-spin
+// `rotated` is whether the shape's last move was a rotation, without which
+// it's no spin at all
+inline Spin tSpin(const Board &board, PieceMask mask, int x, int y,
+                  bool rotated, bool kickedLast) {
+  if (not rotated or std::popcount(mask) != 4) {
+    return Spin::NONE;
+  }
+  auto filled = [&](int cx, int cy) {
+    return cx >= 0 and cx < PIECE_MASK_SIZE and cy >= 0 and
+           cy < PIECE_MASK_SIZE and ((pieceRow(mask, cy) >> cx) & 1);
+  };
+  constexpr std::array<std::array<int, 2>, 4> STEPS{
+      {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+  // The centre is the only cell with three neighbours, and the T points from
+  // it towards the one neighbour without another opposite
+  for (int cy = 0; cy < PIECE_MASK_SIZE; cy++) {
+    for (int cx = 0; cx < PIECE_MASK_SIZE; cx++) {
+      if (not filled(cx, cy)) {
+        continue;
+      }
+      int neighbours = 0;
+      std::array<int, 2> pointing{0, 0};
+      for (auto [dx, dy] : STEPS) {
+        if (filled(cx + dx, cy + dy)) {
+          neighbours++;
+          if (not filled(cx - dx, cy - dy)) {
+            pointing = {dx, dy};
+          }
+        }
+      }
+      if (neighbours != 3) {
+        continue;
+      }
+
+      auto corner = [&](int dx, int dy) {
+        return board.collides(1, x + cx + dx, y + cy + dy);
+      };
+      auto [px, py] = pointing;
+      // Sideways from where it points
+      int sx = py;
+      int sy = px;
+      bool front = corner(px + sx, py + sy) and corner(px - sx, py - sy);
+      int corners = corner(1, 1) + corner(1, -1) + corner(-1, 1) +
+                    corner(-1, -1);
+      if (corners < 3) {
+        return Spin::NONE;
+      }
+      return front or kickedLast ? Spin::FULL : Spin::MINI;
+    }
+  }
+  return Spin::NONE;
+}
+} // namespace scoring
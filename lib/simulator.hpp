@@ -0,0 +1,52 @@
+#pragma once
+
+#include <span>
+
+#include "tetris.hpp"
+
+struct SimulationStats {
+  // How many of the inputs were played before the game ended
+  int inputs{0};
+  int pieces{0};
+  int lines{0};
+  int score{0};
+  bool toppedOut{false};
+};
+
+// Plays games headlessly -- with no rendering or terminal input -- as fast as
+// inputs can be fed in
+template <ShapeFactory Factory> class Simulator {
+private:
+  Tetris<Factory> tetris;
+
+public:
+  explicit Simulator(Tetris<Factory> _tetris) : tetris{std::move(_tetris)} {}
+  explicit Simulator(Factory factory)
+      : Simulator(Tetris<Factory>::createTetris(10, 40, factory).value()) {}
+
+  const Tetris<Factory> &getTetris() const { return tetris; }
+
+  // Starts a new game on the same board, with shapes from `factory`
+  void reset(Factory factory) { tetris.reset(std::move(factory)); }
+
+  SimulationStats stats() const {
+    return {0, tetris.getPieces(), tetris.getLines(), tetris.getScore(),
+            tetris.isToppedOut()};
+  }
+
+  // Plays the inputs in order, until they run out or the game is over
+  SimulationStats run(std::span<const Input> inputs) {
+    int played = 0;
+    for (auto input : inputs) {
+      if (tetris.isToppedOut()) {
+        break;
+      }
+      tetris.handleInput(input);
+      played++;
+    }
+
+    auto result = stats();
+    result.inputs = played;
+    return result;
+  }
+};
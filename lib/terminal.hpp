@@ -0,0 +1,213 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <utility>
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Keyboard input straight from a terminal: raw mode, so keys arrive as they're
+// pressed rather than a line at a time, read without blocking and parsed out
+// of the escape sequences terminals send for keys like the arrows
+
+enum class TerminalError { NOT_A_TERMINAL, CANT_CONFIGURE };
+
+// Puts a terminal into raw mode for as long as it's alive, then puts it back
+// how it was
+class RawTerminal {
+private:
+  int fd;
+  termios original;
+  bool active{true};
+
+  RawTerminal(int _fd, const termios &_original)
+      : fd(_fd), original(_original) {}
+
+public:
+  // Signals are turned off along with everything else, so Ctrl-C arrives as a
+  // key, and the terminal can't be left in raw mode by an interrupt
+  static std::expected<RawTerminal, TerminalError>
+  open(int fd = STDIN_FILENO) {
+    if (not ::isatty(fd)) {
+      return std::unexpected(TerminalError::NOT_A_TERMINAL);
+    }
+    termios original;
+    if (::tcgetattr(fd, &original) != 0) {
+      return std::unexpected(TerminalError::CANT_CONFIGURE);
+    }
+
+    auto raw = original;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cflag |= CS8;
+    // Reads return straight away with whatever's there, even if it's nothing
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (::tcsetattr(fd, TCSAFLUSH, &raw) != 0) {
+      return std::unexpected(TerminalError::CANT_CONFIGURE);
+    }
+    return RawTerminal{fd, original};
+  }
+
+  RawTerminal(RawTerminal &&other) noexcept
+      : fd(other.fd), original(other.original),
+        active(std::exchange(other.active, false)) {}
+  RawTerminal(const RawTerminal &) = delete;
+  RawTerminal &operator=(const RawTerminal &) = delete;
+  RawTerminal &operator=(RawTerminal &&) = delete;
+
+  ~RawTerminal() {
+    if (active) {
+      ::tcsetattr(fd, TCSAFLUSH, &original);
+    }
+  }
+};
+
+enum class KeyCode : std::uint8_t {
+  CHARACTER,
+  UP,
+  DOWN,
+  LEFT,
+  RIGHT,
+  ESCAPE
+};
+
+struct TerminalKey {
+  KeyCode code;
+  // The byte that was typed, for a CHARACTER
+  char character{0};
+
+  bool operator==(const TerminalKey &other) const = default;
+};
+
+// Turns the bytes a terminal sends into keys a byte at a time, so a sequence
+// split across reads still comes out whole
+class KeyParser {
+private:
+  constexpr static char ESC = '\x1b';
+
+  // How far into an escape sequence the parser is: just after the ESC, or
+  // after the "ESC [" or "ESC O" that starts a sequence for a key
+  enum class Stage : std::uint8_t { GROUND, ESCAPE, SEQUENCE };
+  Stage stage{Stage::GROUND};
+
+public:
+  // Calls `emit(key)` for each key `byte` finishes
+  template <typename F> void feed(char byte, F &&emit) {
+    switch (stage) {
+    case Stage::GROUND:
+      if (byte == ESC) {
+        stage = Stage::ESCAPE;
+      } else {
+        emit(TerminalKey{KeyCode::CHARACTER, byte});
+      }
+      return;
+
+    case Stage::ESCAPE:
+      if (byte == '[' or byte == 'O') {
+        stage = Stage::SEQUENCE;
+        return;
+      }
+      // Not a sequence after all, so the ESC was a key by itself
+      emit(TerminalKey{KeyCode::ESCAPE});
+      stage = Stage::GROUND;
+      feed(byte, emit);
+      return;
+
+    case Stage::SEQUENCE:
+      // Parameters and intermediates come before the byte that ends it
+      if (byte >= 0x20 and byte <= 0x3f) {
+        return;
+      }
+      stage = Stage::GROUND;
+      switch (byte) {
+      case 'A':
+        emit(TerminalKey{KeyCode::UP});
+        break;
+      case 'B':
+        emit(TerminalKey{KeyCode::DOWN});
+        break;
+      case 'C':
+        emit(TerminalKey{KeyCode::RIGHT});
+        break;
+      case 'D':
+        emit(TerminalKey{KeyCode::LEFT});
+        break;
+      default:
+        // Some other key, which isn't used
+        break;
+      }
+      return;
+    }
+  }
+
+  // Whether the parser is partway through an escape sequence
+  bool pending() const { return stage != Stage::GROUND; }
+
+  // Called when no more bytes have come for a while, when an ESC still
+  // waiting to see if a sequence follows must have been the escape key
+  template <typename F> void flush(F &&emit) {
+    if (stage == Stage::ESCAPE) {
+      emit(TerminalKey{KeyCode::ESCAPE});
+    }
+    stage = Stage::GROUND;
+  }
+};
+
+// Reads keys from a file descriptor as they arrive, without ever waiting
+// longer than asked to
+class TerminalInput {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // How long after an ESC the rest of a sequence can still arrive, before the
+  // ESC is taken to be the escape key by itself
+  constexpr static std::chrono::milliseconds ESCAPE_TIMEOUT{40};
+
+private:
+  int fd;
+  KeyParser parser;
+  std::array<char, 64> buffer;
+  Clock::time_point lastRead{};
+
+public:
+  explicit TerminalInput(int _fd = STDIN_FILENO) : fd(_fd) {}
+
+  // Waits up to `timeout` for input, then calls `onKey(key)` for every key
+  // that's come in
+  // Returns false once the input has closed
+  template <typename F>
+  bool poll(std::chrono::milliseconds timeout, F &&onKey) {
+    pollfd waiting{fd, POLLIN, 0};
+    int ready = ::poll(&waiting, 1, (int)timeout.count());
+    if (ready < 0) {
+      return errno == EINTR;
+    } else if (ready == 0) {
+      // However short the wait was, the rest of a sequence gets its time to
+      // arrive
+      if (parser.pending() and Clock::now() - lastRead >= ESCAPE_TIMEOUT) {
+        parser.flush(onKey);
+      }
+      return true;
+    } else if (not(waiting.revents & POLLIN)) {
+      return false;
+    }
+
+    auto n = ::read(fd, buffer.data(), buffer.size());
+    if (n < 0) {
+      return errno == EINTR or errno == EAGAIN;
+    } else if (n == 0) {
+      return false;
+    }
+    lastRead = Clock::now();
+    for (int i = 0; i < n; i++) {
+      parser.feed(buffer[i], onKey);
+    }
+    return true;
+  }
+};
@@ -1,34 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+
+#include "controls.hpp"
+#include "engine.hpp"
+#include "renderer.hpp"
+#include "terminal.hpp"
 #include "tetris.hpp"
 
-#define KEY_UP 72
-#define KEY_DOWN 80
-#define KEY_LEFT 75
-#define KEY_RIGHT 77
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr auto FRAME = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(1.0 / gravity::FRAMES_PER_SECOND));
 
-std::unordered_map<char, Input> mapping{{' ', Key::SPACE},
-                                        {'c', Key::HOLD},
-                                        {'q', Rotation::COUNTER_CLOCKWISE},
-                                        {'e', Rotation::CLOCKWISE},
-                                        {KEY_DOWN, Direction::DOWN},
-                                        {KEY_RIGHT, Direction::RIGHT},
-                                        {KEY_LEFT, Direction::LEFT}};
+void writeAll(std::string_view text) {
+  while (not text.empty()) {
+    auto written = ::write(STDOUT_FILENO, text.data(), text.size());
+    if (written <= 0) {
+      return;
+    }
+    text.remove_prefix(written);
+  }
+}
+} // namespace
 
 int main() {
-  auto a = TetrisFactory::standardTetris();
+  auto terminal = RawTerminal::open(STDIN_FILENO);
+  if (not terminal) {
+    std::fputs("tetris needs to be run in a terminal\n", stderr);
+    return 1;
+  }
 
-  char c;
-  while (std::cin.get(c)) {
-    if (mapping.contains(c)) {
-      auto value = mapping[c];
-      a.handleInput(value);
-    }
+  auto seed = (std::uint64_t)Clock::now().time_since_epoch().count();
+  TickEngine<BagShapeFactory> engine{TetrisFactory::seededTetris(seed)};
+  TerminalRenderer renderer;
+  TerminalInput input{STDIN_FILENO};
+
+  // Hide the cursor while playing
+  writeAll("\x1b[?25l");
 
-    a.handleInput(Direction::LEFT);
-    std::cout.flush();
+  // Keys are collected as they arrive and played on the next tick, so input
+  // is never more than a frame behind
+  KeyButtons keys;
+  bool playing = true;
+  auto nextTick = Clock::now();
+  while (playing) {
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(nextTick -
+                                                             Clock::now());
+    bool open = input.poll(std::max(wait, std::chrono::milliseconds{0}),
+                           [&](TerminalKey key) {
+                             if (quits(key)) {
+                               playing = false;
+                             } else {
+                               keys.press(key);
+                             }
+                           });
+    playing = playing and open;
+
+    auto now = Clock::now();
+    if (now >= nextTick) {
+      engine.tick(keys.next());
+      renderer.draw(engine.getTetris());
+      // After falling well behind, say from being suspended, carry on from
+      // now rather than running every missed frame at once
+      nextTick = now - nextTick > 4 * FRAME ? now + FRAME : nextTick + FRAME;
+    }
   }
-  a.handleInput(Direction::DOWN);
-  a.handleInput(Direction::DOWN);
-  a.handleInput(Direction::DOWN);
 
+  // Show the cursor again, below the board
+  writeAll(std::format("\x1b[?25h\x1b[{};1H\n",
+                       TerminalRenderer::VISIBLE_ROWS + 3));
   return 0;
 }
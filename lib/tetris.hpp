@@ -1,16 +1,26 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
 #include <expected>
 #include <functional>
 #include <iostream>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "board.hpp"
+#include "events.hpp"
 #include "helper.hpp"
+#include "random.hpp"
+#include "ring_buffer.hpp"
+#include "scoring.hpp"
 
 enum class Key { HOLD, SPACE };
 enum class Rotation { CLOCKWISE, COUNTER_CLOCKWISE };
@@ -27,15 +37,22 @@ concept ShapeFactory = requires(T s) {
   { s.getShapes() } -> std::same_as<const std::vector<const Shape>>;
 };
 
+// Shape factories that can also deal out several shapes in one go
+template <typename T>
+concept BatchShapeFactory =
+    ShapeFactory<T> and requires(T s, std::span<Shape> out) {
+      { s.fillShapes(out) };
+    };
+
 struct Coord {
   int x;
   int y;
 
-  bool inBounds(int width, int height) const {
+  constexpr bool inBounds(int width, int height) const {
     return x < width and x >= 0 and y < height and y >= 0;
   }
 
-  static Coord directionCoord(Direction direction) {
+  constexpr static Coord directionCoord(Direction direction) {
     switch (direction) {
     case Direction::DOWN:
       return Coord{0, -1};
@@ -51,26 +68,33 @@ struct Coord {
   // It's safe to do this as the relative order in the implicitly public members
   // of `Coord` is preserved
   auto operator<=>(const Coord &other) const = default;
-  Coord operator+(const Coord &other) const {
+  constexpr Coord operator+(const Coord &other) const {
     return {x + other.x, y + other.y};
   }
-  Coord operator+(Direction direction) const {
+  constexpr Coord operator+(Direction direction) const {
     return *this + Coord::directionCoord(direction);
   }
-  Coord operator*(int mul) const { return {x * mul, y * mul}; }
+  constexpr Coord operator*(int mul) const { return {x * mul, y * mul}; }
 };
 
 struct Shape {
-  using KickData = std::array<std::array<Coord, 4>, 4>;
-  Shape(int _size, const Coords &_coords,
-        std::optional<KickData> _kickData = std::nullopt,
-        int _rotationIndex = 0)
-      : size(_size), coords(_coords), kickData(_kickData),
-        rotationIndex(_rotationIndex) {
+  // How many kicks a rotation tries, in order, when it's blocked in place
+  constexpr static int KICKS = 4;
+  using KickData = std::array<std::array<Coord, KICKS>, 4>;
+  // An empty shape, with no cells
+  constexpr Shape() = default;
+  constexpr Shape(int _size, std::initializer_list<Coord> _coords,
+                  const KickData *_kickData = nullptr, int _rotationIndex = 0)
+      : kickData(_kickData), size(_size), rotationIndex(_rotationIndex) {
     if (_size <= 0) {
       throw std::invalid_argument(
           "size cannot be non-positive (must be greater than or equal to 1)");
     }
+    if (_size > PIECE_MASK_SIZE) {
+      throw std::invalid_argument(
+          std::format("size {} is too large (must be less than or equal to {})",
+                      _size, PIECE_MASK_SIZE));
+    }
     if (auto res = std::ranges::find_if(
             _coords, [_size](auto &c) { return not c.inBounds(_size, _size); });
         res != _coords.end()) {
@@ -83,13 +107,35 @@ struct Shape {
           "rotation index {} not in bounds (must be between 0 and 3 inclusive)",
           _rotationIndex));
     }
+
+    // Work out every rotation up front, so rotating is only an index change
+    for (auto &c : _coords) {
+      rotations[_rotationIndex] |= cellBit(c);
+    }
+    for (int i = 1; i < 4; i++) {
+      auto previous = rotations[(_rotationIndex + i - 1) % 4];
+      auto &rotated = rotations[(_rotationIndex + i) % 4];
+      for (int y = 0; y < _size; y++) {
+        for (int x = 0; x < _size; x++) {
+          if (previous & cellBit({x, y})) {
+            rotated |= cellBit({y, _size - 1 - x});
+          }
+        }
+      }
+    }
   }
 
-  std::string name;
-  int size;
-  Coords coords;
-  std::optional<KickData> kickData;
-  int rotationIndex;
+  // Laid out without padding, so that shapes that are the same are the same
+  // byte for byte, as archived keyframes need
+  const KickData *kickData{nullptr};
+  int size{1};
+  int rotationIndex{0};
+  // The cells of the shape in each of its rotations, indexed by rotationIndex
+  std::array<PieceMask, 4> rotations{};
+
+  constexpr static PieceMask cellBit(Coord c) {
+    return static_cast<PieceMask>(1u << (c.y * PIECE_MASK_SIZE + c.x));
+  }
 
   static Coord applyKickRotation(Coord coord, Rotation rotation) {
     switch (rotation) {
@@ -102,31 +148,98 @@ struct Shape {
     }
   }
 
+  constexpr bool operator==(const Shape &other) const = default;
+
+  PieceMask mask() const { return rotations[rotationIndex]; }
+
+  // The cells of the shape in its current rotation
+  Coords coords() const {
+    Coords result;
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        if (mask() & cellBit({x, y})) {
+          result.push_back({x, y});
+        }
+      }
+    }
+    return result;
+  }
+
   Coords transformCoords(const std::function<Coord(const Coord &)> &f) const {
-    return std::ranges::transform_view(coords, f) | std::ranges::to<Coords>();
+    return std::ranges::transform_view(coords(), f) |
+           std::ranges::to<Coords>();
   }
   Shape rotateClockwise() const {
-    auto clockwiseRotate = [this](const auto &coord) -> Coord {
-      return {coord.y, size - 1 - coord.x};
-    };
-    return {
-        size,
-        transformCoords(clockwiseRotate),
-        kickData,
-        (rotationIndex + 1) % 4,
-    };
+    auto rotated = *this;
+    rotated.rotationIndex = (rotationIndex + 1) % 4;
+    return rotated;
   }
 
   Shape rotateCounterClockwise() const {
-    auto counterClosewiseRotate = [this](const auto &coord) -> Coord {
-      return {size - 1 - coord.y, coord.x};
-    };
+    auto rotated = *this;
     // C++'s modulo operator can return <0 numbers, so we add 4
-    return {size, transformCoords(counterClosewiseRotate), kickData,
-            (rotationIndex + 4 - 1) % 4};
+    rotated.rotationIndex = (rotationIndex + 4 - 1) % 4;
+    return rotated;
+  }
+
+  Shape rotate(Rotation rotation) const {
+    switch (rotation) {
+    case Rotation::CLOCKWISE:
+      return rotateClockwise();
+    case Rotation::COUNTER_CLOCKWISE:
+      return rotateCounterClockwise();
+    default:
+      std::unreachable();
+    }
   }
 };
 
+// Where new shapes appear on the board
+inline Coord spawnLocation(const Board &board, const Shape &shape) {
+  return {board.getWidth() / 2 - shape.size / 2,
+          board.getHeight() / 2 - shape.size};
+}
+
+// The top of the playfield, which shapes spawn just under -- anything above it
+// is out of play
+inline int skyline(const Board &board) { return board.getHeight() / 2; }
+
+// Where a shape at `location` ends up after being rotated into `rotated`,
+// trying each of its kicks in turn if it's blocked from rotating in place
+// Returns nothing if the shape can't be rotated at all
+// `kick`, if given, is set to which of the kicks was taken, or -1 when the
+// shape rotated in place
+inline std::optional<Coord> rotatedLocation(const Board &board,
+                                            const Shape &rotated,
+                                            Coord location, Rotation rotation,
+                                            int *kick = nullptr) {
+  if (kick != nullptr) {
+    *kick = -1;
+  }
+  if (not board.collides(rotated.mask(), location.x, location.y)) {
+    // If the shape isn't blocked on rotation, we simply rotate
+    return location;
+  } else if (rotated.kickData == nullptr) {
+    // If the shape doesn't have any kickdata, and it can't be rotated
+    // normally, we do nothing
+    return std::nullopt;
+  }
+
+  // We have kickdata, so we have to visit all of our options there
+  auto &kicks = (*rotated.kickData)[rotated.rotationIndex];
+  for (int i = 0; i < Shape::KICKS; i++) {
+    Coord newLocation = Shape::applyKickRotation(kicks[i], rotation) + location;
+
+    if (not board.collides(rotated.mask(), newLocation.x, newLocation.y)) {
+      if (kick != nullptr) {
+        *kick = i;
+      }
+      return newLocation;
+    }
+  }
+  return std::nullopt;
+}
+
 class StandardShapeFactory {
 public:
   // 0 -> R
@@ -146,26 +259,26 @@ public:
 
 public:
   // tetriminoes
-  static inline const Shape I_BLOCK{
-      4, {{0, 1}, {1, 1}, {2, 1}, {3, 1}}, StandardShapeFactory::I_KICKDATA};
-
-  static inline const Shape T_BLOCK{3,
-                                    {{0, 0}, {0, 1}, {0, 2}, {1, 1}},
-                                    StandardShapeFactory::TLJSZ_KICKDATA};
-  static inline const Shape L_BLOCK{3,
-                                    {{0, 0}, {0, 1}, {0, 2}, {1, 2}},
-                                    StandardShapeFactory::TLJSZ_KICKDATA};
-  static inline const Shape J_BLOCK{3,
-                                    {{1, 0}, {1, 1}, {1, 2}, {0, 2}},
-                                    StandardShapeFactory::TLJSZ_KICKDATA};
-  static inline const Shape S_BLOCK{3,
-                                    {{0, 1}, {0, 2}, {1, 0}, {1, 1}},
-                                    StandardShapeFactory::TLJSZ_KICKDATA};
-  static inline const Shape Z_BLOCK{3,
-                                    {{1, 1}, {1, 2}, {0, 0}, {0, 1}},
-                                    StandardShapeFactory::TLJSZ_KICKDATA};
-
-  static inline const Shape O_BLOCK{3, {{1, 1}, {1, 2}, {2, 1}, {2, 2}}};
+  constexpr static const Shape I_BLOCK{
+      4, {{0, 1}, {1, 1}, {2, 1}, {3, 1}}, &StandardShapeFactory::I_KICKDATA};
+
+  constexpr static const Shape T_BLOCK{3,
+                                       {{0, 0}, {0, 1}, {0, 2}, {1, 1}},
+                                       &StandardShapeFactory::TLJSZ_KICKDATA};
+  constexpr static const Shape L_BLOCK{3,
+                                       {{0, 0}, {0, 1}, {0, 2}, {1, 2}},
+                                       &StandardShapeFactory::TLJSZ_KICKDATA};
+  constexpr static const Shape J_BLOCK{3,
+                                       {{1, 0}, {1, 1}, {1, 2}, {0, 2}},
+                                       &StandardShapeFactory::TLJSZ_KICKDATA};
+  constexpr static const Shape S_BLOCK{3,
+                                       {{0, 1}, {0, 2}, {1, 0}, {1, 1}},
+                                       &StandardShapeFactory::TLJSZ_KICKDATA};
+  constexpr static const Shape Z_BLOCK{3,
+                                       {{1, 1}, {1, 2}, {0, 0}, {0, 1}},
+                                       &StandardShapeFactory::TLJSZ_KICKDATA};
+
+  constexpr static const Shape O_BLOCK{3, {{1, 1}, {1, 2}, {2, 1}, {2, 2}}};
   static inline const std::vector<const Shape> defaultShapes{
       StandardShapeFactory::I_BLOCK, StandardShapeFactory::O_BLOCK,
       StandardShapeFactory::T_BLOCK, StandardShapeFactory::L_BLOCK,
@@ -179,36 +292,193 @@ public:
   };
 };
 
+// Deals shapes like the guideline's random generator: the standard shapes come
+// in bags of one of each, shuffled. Each factory has its own seeded generator,
+// so games are reproducible and don't share any state
+class BagShapeFactory {
+private:
+  constexpr static int BAG_SIZE = 7;
+  // Shapes are dealt out of several bags shuffled at once
+  constexpr static int BAGS_PER_BATCH = 8;
+
+  mutable Xoshiro256 rng;
+  mutable std::array<std::uint8_t, BAG_SIZE * BAGS_PER_BATCH> batch{};
+  mutable std::size_t next = batch.size();
+
+  void refill() const {
+    for (int bag = 0; bag < BAGS_PER_BATCH; bag++) {
+      auto shapes = std::span(batch).subspan(bag * BAG_SIZE, BAG_SIZE);
+      for (int i = 0; i < BAG_SIZE; i++) {
+        shapes[i] = (std::uint8_t)i;
+      }
+      // Fisher-Yates shuffle
+      for (int i = BAG_SIZE - 1; i > 0; i--) {
+        std::swap(shapes[i], shapes[rng.below(i + 1)]);
+      }
+    }
+    next = 0;
+  }
+
+public:
+  BagShapeFactory() : BagShapeFactory(0) {}
+  explicit BagShapeFactory(std::uint64_t seed) : rng{seed} {}
+
+  const std::vector<const Shape> getShapes() const {
+    return StandardShapeFactory::defaultShapes;
+  }
+
+  const Shape getShape() const {
+    if (next == batch.size()) {
+      refill();
+    }
+    return StandardShapeFactory::defaultShapes[batch[next++]];
+  }
+
+  void fillShapes(std::span<Shape> out) const {
+    for (auto &shape : out) {
+      if (next == batch.size()) {
+        refill();
+      }
+      shape = StandardShapeFactory::defaultShapes[batch[next++]];
+    }
+  }
+};
+
 using Input = std::variant<Direction, Key, Rotation>;
 
+enum class GameStatus : std::uint8_t {
+  PLAYING,
+  // A new shape overlapped the stack where it spawned
+  BLOCKED_OUT,
+  // A shape locked entirely above the skyline
+  LOCKED_OUT,
+};
+
+// Everything about a game that changes as it's played, kept in one trivially
+// copyable block (as long as the factory is) so that a game can be snapshotted
+// and restored with a single memcpy
+template <ShapeFactory Factory> struct GameState {
+  Board board;
+  // Dealing moves some factories on, like a bag's generator, so the game keeps
+  // its own copy
+  std::remove_cvref_t<Factory> factory;
+  // Shapes that are coming up next, dealt from the factory in batches -- room
+  // for the longest preview, less the shape just taken, and a batch
+  RingBuffer<Shape, 32> upcoming{};
+  // How many of the upcoming shapes are shown as a preview
+  int previewSize;
+
+  Shape currentShape{};
+  Coord shapeLocation{};
+
+  std::optional<Shape> holdShape = std::nullopt;
+  // If you've held in the turn already
+  bool heldInTurn = false;
+
+  int level{1};
+  int score{0};
+  ScoreChain chain{};
+  // What the last shape to lock did
+  Lock lastLock{};
+  // Whether the shape in play last moved by rotating, and if so whether it
+  // took the last of its kicks, which count towards T-spins
+  bool rotatedLast = false;
+  bool kickedLast = false;
+
+  // Number of shapes placed and rows cleared so far
+  int pieces{0};
+  int lines{0};
+  GameStatus status{GameStatus::PLAYING};
+
+  // Zobrist hash of everything but the board: the shape in play, where it is
+  // and which way round, what's held, and whether it's been held this turn
+  std::uint64_t stateHash{0};
+
+  std::uint64_t hash() const { return board.hash() ^ stateHash; }
+};
+
 template <ShapeFactory Factory> class Tetris {
 private:
-  // tetris board
-  std::vector<std::vector<bool>> cells;
-
-  const Factory factory;
-  Shape currentShape{factory.getShape()};
-  Coord shapeLocation;
+  GameState<Factory> state;
 
 public:
   const int width;
   const int height;
 
 private:
-  std::optional<Shape> holdShape = std::nullopt;
-  // If you've held in the turn already
-  bool heldInTurn = false;
+  // Where to write what happens, if anywhere -- not part of the state, so
+  // restoring a snapshot doesn't change it. The queue only takes one producer,
+  // so copies of the game (like the ones search and rollback play out) never
+  // write to it: only the game it was set on, or one that game is moved into
+  EventQueue *events{nullptr};
 
-  int level{1};
-  int score{0};
-  [[maybe_unused]] double speed{1.0};
+  // Number of rows (from the bottom of the board) shown when printing
+  constexpr static int VISIBLE_ROWS = 20;
 
-  void setCellAt(Coord c, bool b) { cells[height - 1 - c.y][c.x] = b; }
-  bool cellAt(Coord c) const { return cells[height - 1 - c.y][c.x]; }
+  void setCellAt(Coord c, bool b) { state.board.setCellAt(c.x, c.y, b); }
+  bool cellAt(Coord c) const { return state.board.cellAt(c.x, c.y); }
+
+  void emit(GameEvent event) {
+    event.piece = state.pieces;
+    events->tryPush(event);
+  }
+
+  // An event about the shape in play, where it is now
+  GameEvent shapeEvent(EventType type) const {
+    return {.type = type,
+            .mask = state.currentShape.mask(),
+            .x = (std::int8_t)state.shapeLocation.x,
+            .y = (std::int8_t)state.shapeLocation.y};
+  }
+
+  // A new shape has come into play, or failed to
+  void spawned() {
+    if (events) {
+      emit(shapeEvent(state.status == GameStatus::PLAYING
+                          ? EventType::SPAWN
+                          : EventType::GAME_OVER));
+    }
+  }
 
   void resetShapeLocation() {
-    shapeLocation = {width / 2 - currentShape.size / 2,
-                     height / 2 - currentShape.size};
+    state.shapeLocation = spawnLocation(state.board, state.currentShape);
+    if (shapeBlocked(state.shapeLocation, state.currentShape)) {
+      state.status = GameStatus::BLOCKED_OUT;
+    }
+  }
+
+  static std::uint64_t shapeKey(const Shape &shape, std::uint64_t salt) {
+    return zobrist::shape(shape.rotations[0] | (std::uint64_t)shape.size << 16,
+                          salt);
+  }
+
+  // The part of the hash for the shape in play
+  std::uint64_t currentShapeKey() const {
+    return shapeKey(state.currentShape, zobrist::keys.pieceSalt) ^
+           zobrist::keys.rotation[state.currentShape.rotationIndex] ^
+           zobrist::location(state.shapeLocation.x, state.shapeLocation.y);
+  }
+
+  std::uint64_t holdKey() const {
+    if (not state.holdShape) {
+      return 0;
+    }
+    return shapeKey(*state.holdShape, zobrist::keys.holdSalt) ^
+           zobrist::keys.rotation[state.holdShape->rotationIndex];
+  }
+
+  void moveShapeTo(Coord location) {
+    state.stateHash ^=
+        zobrist::location(state.shapeLocation.x, state.shapeLocation.y) ^
+        zobrist::location(location.x, location.y);
+    state.shapeLocation = location;
+  }
+
+  void setHeldInTurn(bool held) {
+    if (held != state.heldInTurn) {
+      state.stateHash ^= zobrist::keys.held;
+    }
+    state.heldInTurn = held;
   }
 
   static std::vector<Coord> absShapeCoords(const Coord &location,
@@ -218,47 +488,64 @@ private:
     return shape.transformCoords(addLocation);
   }
 
-  bool shapeInBounds(Coord &location, const Shape &shape) const {
-    auto coords = absShapeCoords(location, shape);
-    return std::ranges::all_of(
-        coords, [this](const Coord &c) { return c.inBounds(width, height); });
+  // Only Ts can be spun, for scoring
+  static bool isTShape(const Shape &shape) {
+    return shape.size == StandardShapeFactory::T_BLOCK.size and
+           shape.rotations[0] == StandardShapeFactory::T_BLOCK.rotations[0];
   }
 
   bool shapeBlocked(Coord location, const Shape &shape) const {
-    if (not shapeInBounds(location, shape)) {
-      return true;
+    return state.board.collides(shape.mask(), location.x, location.y);
+  }
+
+  // Deals `count` more upcoming shapes
+  void dealUpcoming(int count) {
+    std::array<Shape, decltype(state.upcoming)::capacity()> dealt;
+    auto missing = std::span(dealt).first(count);
+
+    if constexpr (BatchShapeFactory<Factory>) {
+      state.factory.fillShapes(missing);
+    } else {
+      std::ranges::generate(missing,
+                            [this] { return state.factory.getShape(); });
+    }
+    for (auto &shape : missing) {
+      state.upcoming.push_back(shape);
     }
+  }
 
-    auto coords = absShapeCoords(location, shape);
-    return std::ranges::any_of(coords, std::bind_front(&Tetris::cellAt, this));
+  // Takes the next shape off the front of the upcoming shapes
+  Shape nextShape() {
+    auto shape = state.upcoming.pop_front();
+    // Only go back to the factory once the preview has run short, and then
+    // for a whole batch, however long the preview is
+    if ((int)state.upcoming.size() < state.previewSize) {
+      dealUpcoming(DEAL_SIZE);
+    }
+    return shape;
   }
 
   void resetShape(const Shape &shape) {
-    currentShape = shape;
+    state.stateHash ^= currentShapeKey();
+    state.currentShape = shape;
+    state.rotatedLast = false;
     resetShapeLocation();
+    state.stateHash ^= currentShapeKey();
+    spawned();
   }
 
-  int clear() {
-    // Remove from the bottom row to the top
-    auto removedRange = std::ranges::remove_if(
-        std::ranges::reverse_view(cells),
-        [](auto const &c) { return std::ranges::all_of(c, std::identity()); });
-
-    std::ranges::replace_if(
-        removedRange, [](auto) { return true; },
-        std::vector<bool>(width, false));
-
-    return (int)removedRange.size();
-  }
+  // Clears any full rows out of the `count` rows starting at row `y`
+  int clear(int y, int count) { return state.board.clearRows(y, count); }
 
   // Move the current shape a particular direction
   // Returns whether the move leads to a crystallisation of the shape
   bool move(Direction direction) {
-    auto movedLocation = shapeLocation + direction;
+    auto movedLocation = state.shapeLocation + direction;
 
-    if (not shapeBlocked(movedLocation,
-                         currentShape)) { // flowing through air -- let it flow
-      shapeLocation = movedLocation;
+    if (not shapeBlocked(movedLocation, state.currentShape)) {
+      // flowing through air -- let it flow
+      moveShapeTo(movedLocation);
+      state.rotatedLast = false;
       return false;
     }
 
@@ -267,76 +554,95 @@ private:
     }
 
     // blocked + going down means that shape has to be placed
-    for (auto c : absShapeCoords(shapeLocation, currentShape)) {
-      setCellAt(c, true);
+    auto spin = isTShape(state.currentShape)
+                    ? scoring::tSpin(state.board, state.currentShape.mask(),
+                                     state.shapeLocation.x,
+                                     state.shapeLocation.y, state.rotatedLast,
+                                     state.kickedLast)
+                    : Spin::NONE;
+    state.board.place(state.currentShape.mask(), state.shapeLocation.x,
+                      state.shapeLocation.y);
+    auto bottom = std::countr_zero(state.currentShape.mask()) / PIECE_MASK_SIZE;
+    // Locking entirely out of play ends the game
+    bool lockedOut = state.shapeLocation.y + bottom >= skyline(state.board);
+
+    state.pieces++;
+    auto rows = events ? state.board.fullRows(state.shapeLocation.y,
+                                              state.currentShape.size)
+                       : 0;
+
+    // We clear any lines -- only the rows the shape was placed in can have
+    // been filled up
+    state.lastLock = {clear(state.shapeLocation.y, state.currentShape.size),
+                      spin};
+    state.lines += state.lastLock.lines;
+    // Points are scored at the level the rows were cleared on
+    state.score += scoring::award(state.chain, state.lastLock, state.level);
+    state.level = scoring::levelFor(state.lines);
+    if (events) {
+      auto locked = shapeEvent(EventType::LOCK);
+      locked.lock = state.lastLock;
+      emit(locked);
+      if (rows != 0) {
+        emit({.type = EventType::CLEAR, .rows = rows});
+      }
     }
 
-    // We've placed the existing shape, so we replace it
-    currentShape = factory.getShape();
-
-    // Based on the coordinates of the new shape, we reset its location and
-    // reset whether a hold has happened
-    resetShapeLocation();
-    heldInTurn = false;
+    if (lockedOut) {
+      state.status = GameStatus::LOCKED_OUT;
+      if (events) {
+        emit(shapeEvent(EventType::GAME_OVER));
+      }
+      return true;
+    }
 
-    // We clear any lines at the bottom
-    clear();
+    // We've placed the existing shape, so we replace it, resetting its location
+    // and whether a hold has happened
+    resetShape(nextShape());
+    setHeldInTurn(false);
     return true;
   }
 
   // Rotates the current shape clockwise or anti-clockwise
   void rotate(Rotation rotation) {
-    auto rotatedShape = std::invoke([rotation, this] {
-      switch (rotation) {
-      case Rotation::CLOCKWISE:
-        return currentShape.rotateClockwise();
-      case Rotation::COUNTER_CLOCKWISE:
-        return currentShape.rotateCounterClockwise();
-      default:
-        std::unreachable();
-      }
-    });
-
-    if (not shapeBlocked(shapeLocation, rotatedShape)) {
-      // If the shape isn't blocked on rotation, we simply rotate
-      currentShape = std::move(rotatedShape);
-      return;
-    } else if (currentShape.kickData->empty()) {
-      // If the shape doesn't have any kickdata, and it can't be rotated
-      // normally, we do nothing
-      return;
-    }
-
-    // We have kickdata, so we have to visit all of our options there
-    auto kickData = rotatedShape.kickData->data()[rotatedShape.rotationIndex];
-    for (auto &kickOffset : kickData) {
-      Coord newLocation =
-          Shape::applyKickRotation(kickOffset, rotation) + shapeLocation;
-
-      if (not shapeBlocked(newLocation, rotatedShape)) {
-        shapeLocation = newLocation;
-        currentShape = rotatedShape;
-        return;
-      }
+    auto rotatedShape = state.currentShape.rotate(rotation);
+
+    int kick;
+    if (auto location = rotatedLocation(state.board, rotatedShape,
+                                        state.shapeLocation, rotation, &kick)) {
+      state.stateHash ^=
+          zobrist::keys.rotation[state.currentShape.rotationIndex] ^
+          zobrist::keys.rotation[rotatedShape.rotationIndex];
+      // Only the last kick, which moves the shape a column and two rows, makes
+      // a T-spin mini a full one
+      state.kickedLast = kick == Shape::KICKS - 1;
+      state.rotatedLast = true;
+      moveShapeTo(*location);
+      state.currentShape = rotatedShape;
     }
   }
 
   // Put shape in hold state
   void hold() {
-    if (heldInTurn) {
+    if (state.heldInTurn) {
       // If you've held already this turn, a hold operation shouldn't be
       // actionable
       return;
     }
-    if (holdShape.has_value()) {
-      auto temp = std::move(currentShape);
-      resetShape(holdShape.value());
-      holdShape = std::move(temp);
+    if (events) {
+      emit(shapeEvent(EventType::HOLD));
+    }
+    state.stateHash ^= holdKey();
+    if (state.holdShape.has_value()) {
+      auto temp = std::move(state.currentShape);
+      resetShape(state.holdShape.value());
+      state.holdShape = std::move(temp);
     } else {
-      holdShape = std::move(currentShape);
-      resetShape(factory.getShape());
+      state.holdShape = state.currentShape;
+      resetShape(nextShape());
     }
-    heldInTurn = true;
+    state.stateHash ^= holdKey();
+    setHeldInTurn(true);
   }
 
   void handleKey(Key key) {
@@ -346,24 +652,71 @@ private:
       break;
     }
     case Key::SPACE: {
-      // keep moving down until materialization
-      while (true) {
-        auto materialized = move(Direction::DOWN);
-        if (materialized)
-          break;
+      // drop straight onto whatever is below, then materialize
+      auto location = state.shapeLocation;
+      auto distance = state.board.dropDistance(state.currentShape.mask(),
+                                               location.x, location.y);
+      if (distance > 0) {
+        location.y -= distance;
+        moveShapeTo(location);
+        state.rotatedLast = false;
+        state.score += scoring::HARD_DROP * distance;
       }
+      move(Direction::DOWN);
     }
     }
   }
 
-  explicit Tetris(int _width, int _height, Factory _factory)
-      : factory{std::move(_factory)}, width{_width}, height{_height} {
+  explicit Tetris(int _width, int _height, Factory _factory,
+                  int _previewSize = DEFAULT_PREVIEW)
+      : state{.board = {_width, _height},
+              .factory = std::move(_factory),
+              .previewSize = _previewSize},
+        width{_width}, height{_height} {
+    start();
+  }
+
+  // Deals the first shape of a game, and the preview after it
+  void start() {
+    dealUpcoming(state.previewSize + 1);
+    state.currentShape = nextShape();
     resetShapeLocation();
-    cells = std::vector(height, std::vector<bool>(width));
+    state.stateHash = currentShapeKey();
+    spawned();
   }
 
 public:
-  enum class InputError { INVALID_HEIGHT, INVALID_WIDTH };
+  // Copies play on without writing events anywhere, until given a queue of
+  // their own
+  Tetris(const Tetris &other)
+      : state{other.state}, width{other.width}, height{other.height} {}
+  // A moved game takes the queue with it, so the game it was moved from
+  // can't write to it any more
+  Tetris(Tetris &&other) noexcept
+      : state{other.state}, width{other.width}, height{other.height},
+        events{std::exchange(other.events, nullptr)} {}
+  // A game's size is fixed, so only a game of the same size can be moved over
+  // it
+  Tetris &operator=(Tetris &&other) {
+    if (other.width != width or other.height != height) {
+      throw std::invalid_argument(
+          std::format("can't move a {}x{} game over a {}x{} one", other.width,
+                      other.height, width, height));
+    }
+    state = other.state;
+    events = std::exchange(other.events, nullptr);
+    return *this;
+  }
+
+  enum class InputError { INVALID_HEIGHT, INVALID_WIDTH, INVALID_PREVIEW };
+
+  // Limits on how many upcoming shapes can be previewed
+  constexpr static int DEFAULT_PREVIEW = 5;
+  constexpr static int MAX_PREVIEW = 14;
+  // How many shapes are dealt at once when the preview runs short: a bag
+  constexpr static int DEAL_SIZE = 7;
+  static_assert(MAX_PREVIEW - 1 + DEAL_SIZE <=
+                decltype(GameState<Factory>::upcoming)::capacity());
 
   static Tetris<StandardShapeFactory> standardTetris() {
     return Tetris(10, 40);
@@ -371,23 +724,109 @@ public:
 
   static std::expected<Tetris, InputError>
   createTetris(int width, int height,
-               Factory factory = StandardShapeFactory()) {
+               Factory factory = StandardShapeFactory(),
+               int previewSize = DEFAULT_PREVIEW) {
     auto breachesLimit = [&](auto var) {
       return std::ranges::any_of(factory.getShapes(),
                                  [var](auto x) { return x.size > var; });
     };
-    if (breachesLimit(width)) {
+    if (breachesLimit(width) or width > Board::MAX_WIDTH) {
       return std::unexpected(InputError::INVALID_WIDTH);
-    } else if (breachesLimit(height)) {
+    } else if (breachesLimit(height) or height > Board::MAX_HEIGHT) {
       return std::unexpected(InputError::INVALID_HEIGHT);
+    } else if (previewSize < 1 or previewSize > MAX_PREVIEW) {
+      return std::unexpected(InputError::INVALID_PREVIEW);
     }
-    return Tetris(width, height, factory);
+    return Tetris(width, height, factory, previewSize);
   }
 
-  auto getLevel() const { return level; }
-  auto getScore() const { return score; }
+  auto getLevel() const { return state.level; }
+  auto getScore() const { return state.score; }
+  auto getPieces() const { return state.pieces; }
+  auto getLines() const { return state.lines; }
+  GameStatus getStatus() const { return state.status; }
+  bool isToppedOut() const { return state.status != GameStatus::PLAYING; }
+  // Locks in a row that have cleared rows, less one
+  int getCombo() const { return state.chain.combo; }
+  bool isBackToBack() const { return state.chain.backToBack; }
+  const Lock &getLastLock() const { return state.lastLock; }
+
+  const Board &getBoard() const { return state.board; }
+  const Shape &getCurrentShape() const { return state.currentShape; }
+  Coord getShapeLocation() const { return state.shapeLocation; }
+  const std::optional<Shape> &getHoldShape() const { return state.holdShape; }
+  bool canHold() const { return not state.heldInTurn; }
+  // If the shape in play can't fall any further, so moving it down locks it
+  bool isGrounded() const {
+    return shapeBlocked(state.shapeLocation + Direction::DOWN,
+                        state.currentShape);
+  }
+
+  // Zobrist hash of the board, the shape in play (which shape, where and which
+  // way round), the held shape and whether it's been held this turn -- the
+  // upcoming shapes aren't included
+  std::uint64_t hash() const { return state.hash(); }
+
+  // A copy of everything about the game that changes as it's played, which
+  // stays as it was however the game goes on
+  GameState<Factory> snapshot() const {
+    static_assert(std::is_trivially_copyable_v<GameState<Factory>>,
+                  "snapshots need a trivially copyable shape factory");
+    return state;
+  }
+
+  // Puts the game back to how it was when `snapshot` was taken, which must
+  // have been from a game with the same width and height
+  void restore(const GameState<Factory> &snapshot) {
+    static_assert(std::is_trivially_copyable_v<GameState<Factory>>,
+                  "snapshots need a trivially copyable shape factory");
+    if (snapshot.board.getWidth() != width or
+        snapshot.board.getHeight() != height) {
+      throw std::invalid_argument(
+          std::format("snapshot of a {}x{} game can't be restored to a {}x{} "
+                      "game",
+                      snapshot.board.getWidth(), snapshot.board.getHeight(),
+                      width, height));
+    }
+    std::memcpy(&state, &snapshot, sizeof(state));
+  }
+
+  // Starts a new game of the same size and preview with shapes from
+  // `factory`, emptying the board where it is rather than making a new one.
+  // Events carry on going to the same queue
+  void reset(Factory factory) {
+    state.board.reset();
+    state.factory = std::move(factory);
+    state.upcoming.clear();
+    state.currentShape = {};
+    state.shapeLocation = {};
+    state.holdShape = std::nullopt;
+    state.heldInTurn = false;
+    state.level = 1;
+    state.score = 0;
+    state.chain = {};
+    state.lastLock = {};
+    state.rotatedLast = false;
+    state.kickedLast = false;
+    state.pieces = 0;
+    state.lines = 0;
+    state.status = GameStatus::PLAYING;
+    start();
+  }
+
+  // Writes events to `queue` from now on, or to nowhere if it's null. When
+  // the queue is full, events are dropped rather than waited on
+  // Anything replayed after restoring a snapshot is written again
+  void setEventQueue(EventQueue *queue) { events = queue; }
+
+  int getPreviewSize() const { return state.previewSize; }
+  // The `i`th shape coming up after the current one, for i < getPreviewSize()
+  const Shape &getPreview(int i) const { return state.upcoming[i]; }
 
   void handleInput(Input input) {
+    if (state.status != GameStatus::PLAYING) {
+      return;
+    }
     std::visit(overloaded{[this](Direction direction) { move(direction); },
                           [this](Key key) { handleKey(key); },
                           [this](Rotation rotation) { rotate(rotation); }},
@@ -397,18 +836,18 @@ public:
   friend std::ostream &operator<<(std::ostream &stream, Tetris &tetris);
 
   std::vector<std::string> outputRows() {
-    auto copy = cells;
-    for (auto c :
-         Tetris<Factory>::absShapeCoords(shapeLocation, currentShape)) {
-      copy[height - 1 - c.y][c.x] = true;
+    auto copy = state.board;
+    for (auto c : Tetris<Factory>::absShapeCoords(state.shapeLocation,
+                                                  state.currentShape)) {
+      copy.setCellAt(c.x, c.y, true);
     }
 
     std::vector<std::string> rows;
 
-    for (auto r : std::ranges::drop_view(copy, height - 20)) {
+    for (int y = VISIBLE_ROWS - 1; y >= 0; y--) {
       std::ostringstream out;
-      for (auto x : r) {
-        out << x << ' ';
+      for (int x = 0; x < width; x++) {
+        out << copy.cellAt(x, y) << ' ';
       }
       rows.push_back(out.str());
     }
@@ -418,14 +857,14 @@ public:
 
 template <ShapeFactory Factory>
 std::ostream &operator<<(std::ostream &stream, Tetris<Factory> &tetris) {
-  auto copy = tetris.cells;
-  for (auto c : Tetris<Factory>::absShapeCoords(tetris.shapeLocation,
-                                                tetris.currentShape)) {
-    copy[tetris.height - 1 - c.y][c.x] = true;
+  auto copy = tetris.state.board;
+  for (auto c : Tetris<Factory>::absShapeCoords(tetris.state.shapeLocation,
+                                                tetris.state.currentShape)) {
+    copy.setCellAt(c.x, c.y, true);
   }
-  for (auto r : std::ranges::drop_view(copy, tetris.height - 20)) {
-    for (bool x : r) {
-      stream << x << " ";
+  for (int y = Tetris<Factory>::VISIBLE_ROWS - 1; y >= 0; y--) {
+    for (int x = 0; x < tetris.width; x++) {
+      stream << copy.cellAt(x, y) << " ";
     }
     stream << std::endl;
   }
@@ -437,6 +876,11 @@ struct TetrisFactory {
     return Tetris<StandardShapeFactory>::createTetris(10, 40).value();
   }
 
+  static Tetris<BagShapeFactory> seededTetris(std::uint64_t seed) {
+    return Tetris<BagShapeFactory>::createTetris(10, 40, BagShapeFactory{seed})
+        .value();
+  }
+
   static auto defaultTetris(const ShapeFactory auto &t) {
     return Tetris<decltype(t)>::createTetris(10, 40, t).value();
   }
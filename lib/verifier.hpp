@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "archive.hpp"
+#include "farm.hpp"
+
+// Checks recorded games against how their players claimed they ended up, by
+// playing every replay again from the start. Along the way the game is checked
+// against each of the archive's keyframes too, so a game that went wrong can be
+// narrowed down to somewhere between two keyframes
+
+// A game whose replay doesn't back up what was claimed for it
+struct Mismatch {
+  std::size_t game;
+  // Set if the game couldn't be played again at all
+  std::optional<ArchiveError> error;
+  ArchivedResult claimed;
+  ArchivedResult actual;
+  // The first frame by which the game had gone wrong: that of the first
+  // keyframe which disagrees with the replay, or the last frame if it's only
+  // the final result that does
+  std::uint64_t frame{0};
+};
+
+struct VerificationReport {
+  std::size_t verified{0};
+  // In the same order as the games
+  std::vector<Mismatch> mismatches;
+
+  bool ok() const { return mismatches.empty(); }
+};
+
+// How a game stood after `events` events, the last on `frame`
+template <ShapeFactory Factory>
+ArchivedResult resultOf(const GameState<Factory> &state, std::uint64_t events,
+                        std::uint64_t frame) {
+  return {state.hash(),
+          events,
+          frame,
+          state.score,
+          state.lines,
+          state.pieces,
+          state.status != GameStatus::PLAYING};
+}
+
+// Plays game `i` of `archive` again, returning what's wrong with it if
+// anything is
+template <ShapeFactory Factory>
+std::optional<Mismatch> verifyGame(const ReplayArchive<Factory> &archive,
+                                   std::size_t i) {
+  auto game = archive.game(i);
+  if (not game) {
+    return Mismatch{i, game.error(), {}, {}, 0};
+  }
+  auto failed = [&](ArchiveError error) {
+    return Mismatch{i, error, game->result, {}, 0};
+  };
+  auto reader = ReplayReader::open(game->replay);
+  if (not reader) {
+    return failed(ArchiveError::BAD_REPLAY);
+  }
+  auto tetris = startReplay<Factory>(game->header);
+  if (not tetris) {
+    return failed(ArchiveError::BAD_GAME);
+  }
+
+  // The keyframe to check against next, which is keyframe `k`, unless there
+  // are no more
+  auto keyframes = archive.keyframeCount(i);
+  std::size_t k = 0;
+  ArchivedKeyframe<Factory> keyframe{};
+  auto load = [&]() -> bool {
+    if (k < keyframes) {
+      auto loaded = archive.keyframe(i, k);
+      if (not loaded) {
+        return false;
+      }
+      keyframe = *loaded;
+    }
+    return true;
+  };
+  if (not load()) {
+    return failed(ArchiveError::BAD_REPLAY);
+  }
+
+  std::optional<std::uint64_t> wentWrong;
+  std::uint64_t events = 0;
+  while (true) {
+    auto event = reader->next();
+    if (not event) {
+      return failed(ArchiveError::BAD_REPLAY);
+    } else if (not *event) {
+      break;
+    }
+    tetris->handleInput((*event)->input);
+    events++;
+
+    if (k < keyframes and keyframe.events == events) {
+      if (not wentWrong and
+          resultOf(keyframe.state, events, keyframe.frame) !=
+              resultOf(tetris->snapshot(), events, reader->getFrame())) {
+        wentWrong = keyframe.frame;
+      }
+      k++;
+      if (not load()) {
+        return failed(ArchiveError::BAD_REPLAY);
+      }
+    }
+  }
+  // A keyframe past the end of the replay can't be right either
+  if (k < keyframes and not wentWrong) {
+    wentWrong = keyframe.frame;
+  }
+
+  auto actual = resultOf(tetris->snapshot(), events, reader->getFrame());
+  if (not wentWrong and actual == game->result) {
+    return std::nullopt;
+  }
+  return Mismatch{i, std::nullopt, game->result, actual,
+                  wentWrong.value_or(actual.lastFrame)};
+}
+
+// Verifies every game in the archive, spread across the pool
+template <ShapeFactory Factory>
+VerificationReport verifyArchive(WorkStealingPool &pool,
+                                 const ReplayArchive<Factory> &archive) {
+  std::vector<std::optional<Mismatch>> results(archive.size());
+  pool.parallelFor((int)archive.size(), [&](int game, unsigned) {
+    results[game] = verifyGame(archive, game);
+  });
+
+  VerificationReport report{archive.size(), {}};
+  for (auto &result : results) {
+    if (result) {
+      report.mismatches.push_back(*result);
+    }
+  }
+  return report;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "random.hpp"
+
+// Random keys for Zobrist hashing of game state. A state's hash is the XOR of
+// the keys of everything in it, so changing one part of the state only takes
+// XORing its old key out and its new key in
+namespace zobrist {
+constexpr int ROWS = 64;
+constexpr int COLUMNS = 16;
+// How far a shape's bounding box can hang off the board
+constexpr int OFFSET = 4;
+
+struct Keys {
+  // Each cell of the board being filled
+  std::array<std::array<std::uint64_t, COLUMNS>, ROWS> cells{};
+  // Where the shape in play is, and which way round
+  std::array<std::uint64_t, COLUMNS + 2 * OFFSET> pieceX{};
+  std::array<std::uint64_t, ROWS + 2 * OFFSET> pieceY{};
+  std::array<std::uint64_t, 4> rotation{};
+  // Told apart from each other so that a shape in play and the same shape in
+  // hold hash differently
+  std::uint64_t pieceSalt{0};
+  std::uint64_t holdSalt{0};
+  // Having held in the current turn
+  std::uint64_t held{0};
+};
+
+constexpr Keys makeKeys() {
+  Keys keys;
+  std::uint64_t state = 0x5a0b7157;
+  for (auto &row : keys.cells) {
+    for (auto &cell : row) {
+      cell = splitMix64(state);
+    }
+  }
+  for (auto &key : keys.pieceX) {
+    key = splitMix64(state);
+  }
+  for (auto &key : keys.pieceY) {
+    key = splitMix64(state);
+  }
+  for (auto &key : keys.rotation) {
+    key = splitMix64(state);
+  }
+  keys.pieceSalt = splitMix64(state);
+  keys.holdSalt = splitMix64(state);
+  keys.held = splitMix64(state);
+  return keys;
+}
+
+inline constexpr Keys keys = makeKeys();
+
+// The keys of the filled cells of row `y`, with bit `x` of `cells` set when
+// the cell at (x, y) is filled
+constexpr std::uint64_t row(int y, std::uint16_t cells) {
+  std::uint64_t hash = 0;
+  for (unsigned bits = cells; bits != 0; bits &= bits - 1) {
+    hash ^= keys.cells[y][std::countr_zero(bits)];
+  }
+  return hash;
+}
+
+// A key for which shape something is, from the cells of its first rotation
+// (and anything else that tells shapes apart) mixed with a salt
+constexpr std::uint64_t shape(std::uint64_t identity, std::uint64_t salt) {
+  auto state = identity ^ salt;
+  return splitMix64(state);
+}
+
+constexpr std::uint64_t location(int x, int y) {
+  return keys.pieceX[x + OFFSET] ^ keys.pieceY[y + OFFSET];
+}
+} // namespace zobrist
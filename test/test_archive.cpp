@@ -0,0 +1,188 @@
+#include "catch2/catch.hpp"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../fixtures/replay_fixtures.hpp"
+#include "../lib/archive.hpp"
+
+namespace {
+// The game as it was at the end of `frame`, played straight from the start
+Tetris<BagShapeFactory> playTo(std::span<const std::uint8_t> replay,
+                               std::uint64_t frame) {
+  auto reader = ReplayReader::open(replay).value();
+  auto tetris = startReplay<BagShapeFactory>(reader.getHeader()).value();
+  while (auto event = reader.next().value()) {
+    if (event->frame > frame) {
+      break;
+    }
+    tetris.handleInput(event->input);
+  }
+  return tetris;
+}
+} // namespace
+
+TEST_CASE("ReplayArchive") {
+  TempFile file{"test_archive.tarc"};
+  std::vector<std::vector<std::uint8_t>> replays;
+  for (std::uint64_t seed = 1; seed <= 5; seed++) {
+    replays.push_back(recordGame(seed, 300 * (int)seed));
+  }
+
+  {
+    std::ofstream out{file.path, std::ios::binary};
+    ArchiveWriter<BagShapeFactory> writer{out, 64};
+    for (auto &replay : replays) {
+      REQUIRE(writer.addGame(replay));
+    }
+  }
+
+  auto archive = ReplayArchive<BagShapeFactory>::open(file.path).value();
+  REQUIRE(archive.size() == replays.size());
+
+  for (std::size_t i = 0; i < replays.size(); i++) {
+    auto game = archive.game(i).value();
+    REQUIRE(std::ranges::equal(game.replay, replays[i]));
+    REQUIRE(game.header.seed == i + 1);
+
+    auto end = playTo(replays[i], UINT64_MAX);
+    REQUIRE(game.result.hash == end.hash());
+    REQUIRE(game.result.pieces == end.getPieces());
+
+    // Seeking lands on the same state as playing from the start, whether the
+    // frame is before the first keyframe, on one or between them
+    for (std::uint64_t frame :
+         {std::uint64_t{0}, std::uint64_t{10}, game.result.lastFrame / 3,
+          game.result.lastFrame / 2 + 1, game.result.lastFrame}) {
+      auto seeked = archive.seek(i, frame).value();
+      auto played = playTo(replays[i], frame);
+      REQUIRE(seeked.hash() == played.hash());
+      REQUIRE(seeked.getPieces() == played.getPieces());
+      REQUIRE(seeked.getPreview(0) == played.getPreview(0));
+    }
+  }
+}
+
+TEST_CASE("ReplayArchiveDeterministic") {
+  auto write = [](std::uint8_t scribble) {
+    // Leave different junk on the stack each time, where any padding copied
+    // into a keyframe would come from
+    volatile std::uint8_t junk[1 << 16];
+    for (auto &byte : junk) {
+      byte = scribble;
+    }
+
+    std::ostringstream out;
+    {
+      ArchiveWriter<BagShapeFactory> writer{out, 16};
+      for (std::uint64_t seed = 1; seed <= 5; seed++) {
+        REQUIRE(writer.addGame(recordGame(seed, 300)));
+      }
+    }
+    return out.str();
+  };
+
+  // The same games make the same archive, byte for byte
+  auto first = write(0x00);
+  auto second = write(0xa5);
+  REQUIRE(first.size() == second.size());
+  REQUIRE(std::memcmp(first.data(), second.data(), first.size()) == 0);
+
+  // And where the kick tables are in memory isn't written out
+  for (auto *table : {&StandardShapeFactory::I_KICKDATA,
+                      &StandardShapeFactory::TLJSZ_KICKDATA}) {
+    std::string address(sizeof(table), '\0');
+    std::memcpy(address.data(), (const void *)&table, sizeof(table));
+    REQUIRE(first.find(address) == std::string::npos);
+  }
+}
+
+TEST_CASE("ReplayArchiveErrors") {
+  TempFile file{"test_archive_errors.tarc"};
+  REQUIRE(ReplayArchive<BagShapeFactory>::open(file.path).error() ==
+          ArchiveError::CANT_OPEN);
+
+  {
+    std::ofstream out{file.path, std::ios::binary};
+    out << "not an archive at all, but long enough to have a footer";
+  }
+  REQUIRE(ReplayArchive<BagShapeFactory>::open(file.path).error() ==
+          ArchiveError::BAD_FORMAT);
+
+  std::ostringstream out;
+  REQUIRE_THROWS_AS((ArchiveWriter<BagShapeFactory>{out, 0}),
+                    std::invalid_argument);
+  REQUIRE(out.str().empty());
+
+  ArchiveWriter<BagShapeFactory> writer{out};
+  auto replay = recordGame(1, 10);
+  replay.resize(replay.size() - 2);
+  REQUIRE(writer.addGame(replay).error() == ArchiveError::BAD_REPLAY);
+}
+
+TEST_CASE("ReplayArchiveCorrupt") {
+  using namespace archive_detail;
+  TempFile file{"test_archive_corrupt.tarc"};
+  std::ostringstream out;
+  {
+    ArchiveWriter<BagShapeFactory> writer{out, 16};
+    REQUIRE(writer.addGame(recordGame(1, 300)));
+  }
+  auto archive = out.str();
+  auto bytes = std::span(reinterpret_cast<const std::uint8_t *>(archive.data()),
+                         archive.size());
+  auto footer = load<Footer>(bytes.last(sizeof(Footer)));
+  auto entry = load<IndexEntry>(bytes.subspan(footer.indexOffset));
+
+  // Writes `archive` with `value` copied over it at `offset`
+  auto patch = [&](std::size_t offset, const auto &value) {
+    auto patched = archive;
+    std::memcpy(patched.data() + offset, &value, sizeof(value));
+    std::ofstream{file.path, std::ios::binary} << patched;
+  };
+
+  SECTION("IndexOutOfBounds") {
+    // Offsets and sizes that only fit if adding them wraps around
+    auto wrapping = entry;
+    wrapping.replayOffset = UINT64_MAX - 7;
+    wrapping.replaySize = 16;
+    patch(footer.indexOffset, wrapping);
+    REQUIRE(ReplayArchive<BagShapeFactory>::open(file.path).error() ==
+            ArchiveError::BAD_FORMAT);
+
+    wrapping = entry;
+    wrapping.keyframeCount = UINT64_MAX / sizeof(Keyframe<BagShapeFactory>) + 2;
+    patch(footer.indexOffset, wrapping);
+    REQUIRE(ReplayArchive<BagShapeFactory>::open(file.path).error() ==
+            ArchiveError::BAD_FORMAT);
+  }
+
+  SECTION("BadKeyframe") {
+    REQUIRE(entry.keyframeCount > 0);
+    auto keyframe = load<Keyframe<BagShapeFactory>>(
+        bytes.subspan(entry.keyframesOffset));
+
+    auto corrupt = [&](auto change) {
+      auto changed = keyframe;
+      change(changed);
+      patch(entry.keyframesOffset, changed);
+      auto archive = ReplayArchive<BagShapeFactory>::open(file.path).value();
+      REQUIRE(archive.keyframe(0, 0).error() == ArchiveError::BAD_FORMAT);
+      REQUIRE(archive.seek(0, keyframe.frame).error() ==
+              ArchiveError::BAD_FORMAT);
+    };
+    corrupt([](auto &k) { k.state.currentShape.rotationIndex = 7; });
+    corrupt([](auto &k) { k.state.currentShape.size = -1; });
+    corrupt([](auto &k) { k.kickTables[0] = 200; });
+    corrupt([](auto &k) { k.state.shapeLocation.x = 1000; });
+    corrupt([](auto &k) { k.state.previewSize = 0; });
+    corrupt([](auto &k) { k.state.board = Board{10, 100}; });
+    corrupt([](auto &k) {
+      // A ring buffer whose front is past the end of its storage
+      std::memset(&k.state.upcoming, 0xff, sizeof(k.state.upcoming));
+    });
+  }
+}
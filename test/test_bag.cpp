@@ -0,0 +1,41 @@
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <vector>
+
+#include "../lib/tetris.hpp"
+
+static_assert(ShapeFactory<BagShapeFactory>);
+
+namespace {
+// Which of the standard shapes each dealt shape is
+std::vector<int> deal(const BagShapeFactory &factory, int count) {
+  auto &shapes = StandardShapeFactory::defaultShapes;
+  std::vector<int> dealt;
+  for (int i = 0; i < count; i++) {
+    auto shape = factory.getShape();
+    dealt.push_back((int)(std::ranges::find(shapes, shape) - shapes.begin()));
+  }
+  return dealt;
+}
+} // namespace
+
+TEST_CASE("BagShapeFactory") {
+  SECTION("EveryBagHasOneOfEach") {
+    auto dealt = deal(BagShapeFactory{1234}, 7 * 100);
+    for (size_t bag = 0; bag < dealt.size(); bag += 7) {
+      std::vector<int> shapes(dealt.begin() + bag, dealt.begin() + bag + 7);
+      std::ranges::sort(shapes);
+      REQUIRE(shapes == std::vector{0, 1, 2, 3, 4, 5, 6});
+    }
+  }
+  SECTION("SameSeedSameShapes") {
+    REQUIRE(deal(BagShapeFactory{42}, 500) == deal(BagShapeFactory{42}, 500));
+    REQUIRE(deal(BagShapeFactory{42}, 500) != deal(BagShapeFactory{43}, 500));
+  }
+  SECTION("CopiesCarryOn") {
+    BagShapeFactory factory{7};
+    deal(factory, 10);
+    auto copy = factory;
+    REQUIRE(deal(factory, 100) == deal(copy, 100));
+  }
+}
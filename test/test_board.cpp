@@ -0,0 +1,155 @@
+#include "catch2/catch.hpp"
+
+#include "../lib/board.hpp"
+
+TEST_CASE("BoardCells") {
+  Board board{10, 40};
+
+  SECTION("StartsEmpty") {
+    REQUIRE(std::ranges::all_of(board.usedRows(),
+                                [](auto row) { return row == 0; }));
+  }
+  SECTION("SetAndUnset") {
+    board.setCellAt(3, 5, true);
+    REQUIRE(board.cellAt(3, 5));
+    REQUIRE_FALSE(board.cellAt(4, 5));
+    REQUIRE(board.rowAt(5) == 0b1000);
+
+    board.setCellAt(3, 5, false);
+    REQUIRE_FALSE(board.cellAt(3, 5));
+  }
+}
+
+TEST_CASE("BoardClear") {
+  Board board{4, 6};
+  auto fillRow = [&board](int y) {
+    for (int x = 0; x < board.getWidth(); x++) {
+      board.setCellAt(x, y, true);
+    }
+  };
+
+  SECTION("NothingToClear") {
+    board.setCellAt(0, 0, true);
+    REQUIRE(board.clear() == 0);
+    REQUIRE(board.cellAt(0, 0));
+  }
+  SECTION("RowsAboveFall") {
+    fillRow(0);
+    board.setCellAt(1, 1, true);
+    fillRow(2);
+    board.setCellAt(2, 3, true);
+
+    REQUIRE(board.clear() == 2);
+    REQUIRE(board.rowAt(0) == 0b0010);
+    REQUIRE(board.rowAt(1) == 0b0100);
+    REQUIRE(board.rowAt(2) == 0);
+    REQUIRE(board.rowAt(3) == 0);
+  }
+}
+
+TEST_CASE("BoardCollides") {
+  Board board{10, 40};
+  // A horizontal line of 4 along the bottom of the bounding box
+  PieceMask line = 0b1111;
+  // A vertical line of 4 along the right of a 2-wide bounding box
+  PieceMask column = 0b0010'0010'0010'0010;
+
+  SECTION("InsideEmptyBoard") {
+    REQUIRE_FALSE(board.collides(line, 0, 0));
+    REQUIRE_FALSE(board.collides(line, 6, 39));
+    REQUIRE_FALSE(board.collides(column, -1, 36));
+  }
+  SECTION("OutOfBounds") {
+    REQUIRE(board.collides(line, -1, 0));
+    REQUIRE(board.collides(line, 7, 0));
+    REQUIRE(board.collides(line, 0, -1));
+    REQUIRE(board.collides(column, 0, 37));
+    REQUIRE(board.collides(column, -2, 0));
+    REQUIRE(board.collides(line, -100, 0));
+    REQUIRE(board.collides(line, 100, 0));
+  }
+  SECTION("FilledCells") {
+    board.setCellAt(5, 3, true);
+    REQUIRE(board.collides(line, 2, 3));
+    REQUIRE_FALSE(board.collides(line, 2, 4));
+    REQUIRE(board.collides(column, 4, 0));
+    REQUIRE_FALSE(board.collides(column, 5, 0));
+  }
+}
+
+TEST_CASE("BoardDropDistance") {
+  Board board{10, 40};
+  PieceMask line = 0b1111;
+  // An upside-down T, filling the middle of the row above its base
+  PieceMask tee = 0b0010'0111;
+
+  SECTION("EmptyBoard") {
+    REQUIRE(board.dropDistance(line, 0, 20) == 20);
+    REQUIRE(board.dropDistance(line, 0, 0) == 0);
+  }
+  SECTION("LandsOnStack") {
+    board.setCellAt(1, 4, true);
+    board.setCellAt(6, 9, true);
+    REQUIRE(board.columnHeight(1) == 5);
+    REQUIRE(board.dropDistance(line, 0, 20) == 15);
+    REQUIRE(board.dropDistance(line, 3, 20) == 10);
+    REQUIRE(board.dropDistance(tee, 0, 20) == 15);
+    REQUIRE(board.dropDistance(tee, 5, 20) == 10);
+  }
+  SECTION("TuckedUnderOverhang") {
+    board.setCellAt(0, 10, true);
+    board.setCellAt(2, 3, true);
+    REQUIRE(board.dropDistance(line, 0, 5) == 1);
+  }
+  SECTION("HeightsFollowClears") {
+    for (int x = 0; x < board.getWidth(); x++) {
+      board.setCellAt(x, 0, true);
+    }
+    board.setCellAt(3, 1, true);
+    board.clear();
+    REQUIRE(board.columnHeight(3) == 1);
+    REQUIRE(board.columnHeight(4) == 0);
+    REQUIRE(board.dropDistance(line, 3, 10) == 9);
+  }
+}
+
+TEST_CASE("BoardPlaceAndClearRows") {
+  Board board{4, 8};
+  // An L, with its foot sticking out to the right along the bottom
+  PieceMask ell = 0b0001'0001'0011;
+
+  SECTION("Place") {
+    board.place(ell, 2, 1);
+    REQUIRE(board.rowAt(1) == 0b1100);
+    REQUIRE(board.rowAt(2) == 0b0100);
+    REQUIRE(board.rowAt(3) == 0b0100);
+    REQUIRE(board.columnHeight(2) == 4);
+    REQUIRE(board.columnHeight(3) == 2);
+  }
+  SECTION("OnlyInspectsGivenRows") {
+    board.place(0b1111, 0, 0);
+    board.place(0b1111, 0, 5);
+    board.setCellAt(1, 6, true);
+
+    REQUIRE(board.clearRows(4, 4) == 1);
+    REQUIRE(board.rowAt(0) == 0b1111);
+    REQUIRE(board.rowAt(5) == 0b0010);
+    REQUIRE(board.rowAt(6) == 0);
+    REQUIRE(board.columnHeight(1) == 6);
+    REQUIRE(board.columnHeight(0) == 1);
+  }
+  SECTION("ClearsSplitRows") {
+    board.place(0b1111, 0, 1);
+    board.place(ell, 0, 2);
+    board.place(0b1111, 0, 3);
+    board.setCellAt(2, 5, true);
+
+    REQUIRE(board.clearRows(1, 4) == 2);
+    REQUIRE(board.rowAt(0) == 0);
+    REQUIRE(board.rowAt(1) == 0b0011);
+    REQUIRE(board.rowAt(2) == 0b0001);
+    REQUIRE(board.rowAt(3) == 0b0100);
+    REQUIRE(board.columnHeight(0) == 3);
+    REQUIRE(board.columnHeight(3) == 0);
+  }
+}
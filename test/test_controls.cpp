@@ -0,0 +1,93 @@
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <vector>
+
+#include "../lib/controls.hpp"
+
+namespace {
+using Engine = TickEngine<BagShapeFactory>;
+
+constexpr TerminalKey LEFT{KeyCode::LEFT};
+constexpr TerminalKey DOWN{KeyCode::DOWN};
+
+// Runs `frames` frames, typing `key` before each of the frames in `typed`
+void play(Engine &engine, KeyButtons &keys, int frames, TerminalKey key,
+          const std::vector<int> &typed) {
+  for (int frame = 0; frame < frames; frame++) {
+    if (std::ranges::find(typed, frame) != typed.end()) {
+      keys.press(key);
+    }
+    engine.tick(keys.next());
+  }
+}
+} // namespace
+
+TEST_CASE("KeyButtons") {
+  REQUIRE(buttonFor(LEFT) == Button::LEFT);
+  REQUIRE(buttonFor(DOWN) == Button::SOFT_DROP);
+  REQUIRE(buttonFor({KeyCode::UP}) == Button::CLOCKWISE);
+  REQUIRE(buttonFor({KeyCode::CHARACTER, ' '}) == Button::HARD_DROP);
+  REQUIRE(buttonFor({KeyCode::CHARACTER, 'x'}) == std::nullopt);
+  REQUIRE(quits({KeyCode::CHARACTER, '\x03'}));
+  REQUIRE_FALSE(quits({KeyCode::CHARACTER, 'q'}));
+
+  KeyButtons keys;
+  REQUIRE_FALSE(keys.press({KeyCode::ESCAPE}));
+  REQUIRE(keys.press(LEFT));
+  for (int frame = 0; frame < KeyButtons::HOLD_FRAMES; frame++) {
+    REQUIRE(keys.next() == Buttons{Button::LEFT});
+  }
+  REQUIRE(keys.next() == Buttons{});
+}
+
+TEST_CASE("KeyButtonsSoftDrop") {
+  Engine dropped{TetrisFactory::seededTetris(1)};
+  Engine fell{TetrisFactory::seededTetris(1)};
+  auto spawn = fell.getTetris().getShapeLocation().y;
+  KeyButtons keys;
+  auto fallen = [&](Engine &engine) {
+    return spawn - engine.getTetris().getShapeLocation().y;
+  };
+
+  // A tap of down drops the shape a row sooner than gravity would have
+  play(dropped, keys, 10, DOWN, {0});
+  play(fell, keys, 10, DOWN, {});
+  REQUIRE(fallen(dropped) >= fallen(fell) + 1);
+
+  // And a second tap drops it further again, rather than being lost
+  auto once = fallen(dropped);
+  play(dropped, keys, 10, DOWN, {0});
+  REQUIRE(fallen(dropped) >= once + 1);
+
+  // Holding it down keeps the shape falling fast, through the terminal's key
+  // repeat, so it lands and locks in a couple of seconds rather than the
+  // better part of a minute
+  std::vector<int> repeats;
+  for (int frame = 0; frame < 120; frame += 2) {
+    repeats.push_back(frame);
+  }
+  play(dropped, keys, 120, DOWN, repeats);
+  REQUIRE(dropped.getTetris().getPieces() == 1);
+}
+
+TEST_CASE("KeyButtonsShift") {
+  Engine engine{TetrisFactory::seededTetris(1)};
+  auto spawn = engine.getTetris().getShapeLocation().x;
+  KeyButtons keys;
+
+  // A tap shifts once, however long the frames it holds left for
+  play(engine, keys, 20, LEFT, {0});
+  REQUIRE(engine.getTetris().getShapeLocation().x == spawn - 1);
+
+  // Held down, the key repeats after a pause, which holds left long enough
+  // for auto shift to take it to the wall
+  std::vector<int> typed{0};
+  for (int frame = 30; frame < 60; frame += 2) {
+    typed.push_back(frame);
+  }
+  play(engine, keys, 60, LEFT, typed);
+  auto &tetris = engine.getTetris();
+  REQUIRE(tetris.getBoard().collides(tetris.getCurrentShape().mask(),
+                                     tetris.getShapeLocation().x - 1,
+                                     tetris.getShapeLocation().y));
+}
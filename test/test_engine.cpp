@@ -0,0 +1,168 @@
+#include "catch2/catch.hpp"
+#include <vector>
+
+#include "../lib/engine.hpp"
+
+namespace {
+using Engine = TickEngine<BagShapeFactory>;
+
+// Ticks until the shape in play lands, returning how many frames that took
+int landWith(Engine &engine, Buttons buttons) {
+  int frames = 0;
+  while (not engine.getTetris().isGrounded()) {
+    engine.tick(buttons);
+    frames++;
+  }
+  return frames;
+}
+} // namespace
+
+TEST_CASE("GravityCurve") {
+  REQUIRE(gravity::perFrame(1) == gravity::CELL / 60);
+  REQUIRE(gravity::perFrame(0) == gravity::perFrame(1));
+  REQUIRE(gravity::perFrame(gravity::MAX_LEVEL) == gravity::MAX);
+  REQUIRE(gravity::perFrame(99) == gravity::MAX);
+  REQUIRE(std::ranges::is_sorted(gravity::curve));
+}
+
+TEST_CASE("TickEngine") {
+  Engine engine{TetrisFactory::seededTetris(1)};
+  auto spawn = engine.getTetris().getShapeLocation();
+
+  SECTION("Gravity") {
+    for (int frame = 1; frame <= 300; frame++) {
+      engine.tick({});
+      auto fallen = (int)(frame * gravity::perFrame(1) / gravity::CELL);
+      REQUIRE(engine.getTetris().getShapeLocation().y == spawn.y - fallen);
+    }
+  }
+
+  SECTION("SoftDrop") {
+    auto frames = landWith(engine, {Button::SOFT_DROP});
+    // Twenty times as fast as gravity, give or take a frame
+    auto rows = spawn.y - engine.getTetris().getShapeLocation().y;
+    REQUIRE(frames <= rows * 60 / 20 + 1);
+    REQUIRE(engine.getTetris().getPieces() == 0);
+  }
+
+  SECTION("LockDelay") {
+    landWith(engine, {Button::SOFT_DROP});
+    // The frame it lands on counts towards the delay
+    for (int frame = 2; frame < Timing{}.lockDelay; frame++) {
+      engine.tick({});
+      REQUIRE(engine.getTetris().getPieces() == 0);
+    }
+    engine.tick({});
+    REQUIRE(engine.getTetris().getPieces() == 1);
+  }
+
+  SECTION("LockResets") {
+    landWith(engine, {Button::SOFT_DROP});
+    // Tapping left and right every ten frames keeps restarting the lock
+    // delay, until it's been restarted too many times
+    for (int reset = 1; reset <= Timing{}.maxLockResets; reset++) {
+      for (int frame = 1; frame < 10; frame++) {
+        engine.tick({});
+        REQUIRE(engine.getTetris().getPieces() == 0);
+      }
+      engine.tick({reset % 2 ? Button::LEFT : Button::RIGHT});
+    }
+    REQUIRE(engine.getTetris().getPieces() == 1);
+  }
+
+  SECTION("AutoShift") {
+    engine.tick({Button::LEFT});
+    REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 1);
+    for (int frame = 2; frame < Timing{}.das + 1; frame++) {
+      engine.tick({Button::LEFT});
+      REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 1);
+    }
+    // Once the delay's up, it shifts every other frame
+    engine.tick({Button::LEFT});
+    REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 2);
+    engine.tick({Button::LEFT});
+    REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 2);
+    engine.tick({Button::LEFT});
+    REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 3);
+
+    // Pressing right takes over from left, and shifts straight away
+    engine.tick({Button::LEFT, Button::RIGHT});
+    REQUIRE(engine.getTetris().getShapeLocation().x == spawn.x - 2);
+  }
+
+  SECTION("PressedOnce") {
+    for (int frame = 0; frame < 5; frame++) {
+      engine.tick({Button::HARD_DROP, Button::CLOCKWISE});
+    }
+    REQUIRE(engine.getTetris().getPieces() == 1);
+    REQUIRE(engine.getTetris().getCurrentShape().rotationIndex == 0);
+  }
+}
+
+TEST_CASE("TickEngineInstantShift") {
+  Engine engine{TetrisFactory::seededTetris(1), {.arr = 0}};
+  // The first frame shifts once, then it waits out the delay
+  for (int frame = 0; frame <= Timing{}.das; frame++) {
+    engine.tick({Button::RIGHT});
+  }
+  auto &tetris = engine.getTetris();
+  REQUIRE(tetris.getBoard().collides(tetris.getCurrentShape().mask(),
+                                     tetris.getShapeLocation().x + 1,
+                                     tetris.getShapeLocation().y));
+}
+
+TEST_CASE("TickEngineDeterministic") {
+  Engine first{TetrisFactory::seededTetris(5)};
+  Engine second{TetrisFactory::seededTetris(5)};
+  Xoshiro256 rng{5};
+  for (int frame = 0; frame < 5000; frame++) {
+    Buttons buttons;
+    buttons.bits = (std::uint8_t)rng.below(128);
+    first.tick(buttons);
+    second.tick(buttons);
+  }
+  REQUIRE(first.getTetris().getPieces() > 0);
+  REQUIRE(first.getTetris().hash() == second.getTetris().hash());
+}
+
+TEST_CASE("TickEngineSnapshot") {
+  Engine engine{TetrisFactory::seededTetris(7)};
+  Xoshiro256 rng{7};
+  // Anything but hard drops, so that the stack builds up slowly
+  auto randomButtons = [&] {
+    Buttons buttons;
+    buttons.bits =
+        (std::uint8_t)(rng.below(128) & ~Buttons::bit(Button::HARD_DROP));
+    return buttons;
+  };
+  for (int frame = 0; frame < 500; frame++) {
+    engine.tick(randomButtons());
+  }
+  REQUIRE_FALSE(engine.getTetris().isToppedOut());
+
+  // Held partway into shifting, with the next shape partway down
+  for (int frame = 0; frame < 5; frame++) {
+    engine.tick({Button::LEFT});
+  }
+  auto snapshot = engine.snapshot();
+  REQUIRE(snapshot.tick.shiftTimer > 0);
+
+  std::vector<Buttons> buttons;
+  for (int frame = 0; frame < 200; frame++) {
+    buttons.push_back(frame < 20 ? Buttons{Button::LEFT} : randomButtons());
+  }
+  auto play = [&] {
+    std::vector<std::uint64_t> hashes;
+    for (auto held : buttons) {
+      engine.tick(held);
+      hashes.push_back(engine.getTetris().hash());
+    }
+    return hashes;
+  };
+
+  // Playing the same frames again from the snapshot times everything the same
+  auto first = play();
+  engine.restore(snapshot);
+  REQUIRE(engine.frame() == snapshot.tick.frame);
+  REQUIRE(play() == first);
+}
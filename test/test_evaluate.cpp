@@ -0,0 +1,62 @@
+#include "catch2/catch.hpp"
+
+#include "../lib/evaluate.hpp"
+#include "../lib/random.hpp"
+
+TEST_CASE("BoardFeatures") {
+  SECTION("EmptyBoard") {
+    Board board{10, 40};
+    auto features = BoardEvaluator::features(board);
+    REQUIRE(features == BoardFeatures{0, 0, 0, 0, 0, 0, 10});
+  }
+  SECTION("SmallStack") {
+    Board board{4, 8};
+    // x . x x
+    // x . . .   <- top row, with the floor below
+    board.place(0b0001'1011, 0, 0);
+    board.setCellAt(0, 1, true);
+    board.setCellAt(1, 1, false);
+
+    auto features = BoardEvaluator::features(board);
+    REQUIRE(features.aggregateHeight == 4);
+    REQUIRE(features.maxHeight == 2);
+    REQUIRE(features.holes == 0);
+    REQUIRE(features.bumpiness == 3);
+    REQUIRE(features.wells == 1);
+    REQUIRE(features.rowTransitions == 4);
+    REQUIRE(features.columnTransitions == 4);
+  }
+  SECTION("Holes") {
+    Board board{4, 8};
+    board.setCellAt(1, 3, true);
+    board.setCellAt(2, 0, true);
+    board.setCellAt(2, 2, true);
+    REQUIRE(BoardEvaluator::features(board).holes == 4);
+  }
+}
+
+TEST_CASE("BoardFeaturesMatchReference") {
+  // The builds of this test for each instruction set say which kernel they
+  // expect, so that a vector kernel can't quietly fall back to the scalar one
+#ifdef EXPECTED_KERNEL
+  REQUIRE(BoardEvaluator::KERNEL == EXPECTED_KERNEL);
+#endif
+
+  Xoshiro256 rng{99};
+  for (int width : {4, 10, 16}) {
+    for (int i = 0; i < 200; i++) {
+      Board board{width, Board::MAX_HEIGHT};
+      int top = (int)rng.below(Board::MAX_HEIGHT + 1);
+      for (int y = 0; y < top; y++) {
+        for (int x = 0; x < width; x++) {
+          board.setCellAt(x, y, rng.below(3) != 0);
+        }
+      }
+
+      for (int limit : {0, top / 2, top}) {
+        REQUIRE(BoardEvaluator::rowSums(board, limit) ==
+                BoardEvaluator::rowSumsReference(board, limit));
+      }
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#include "catch2/catch.hpp"
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../lib/tetris.hpp"
+
+namespace {
+std::vector<GameEvent> drain(EventQueue &queue) {
+  std::vector<GameEvent> events;
+  queue.drain([&](const GameEvent &event) { events.push_back(event); });
+  return events;
+}
+
+std::vector<EventType> types(const std::vector<GameEvent> &events) {
+  std::vector<EventType> result;
+  for (auto &event : events) {
+    result.push_back(event.type);
+  }
+  return result;
+}
+} // namespace
+
+TEST_CASE("SpscRingBuffer") {
+  SECTION("DropsWhenFull") {
+    SpscRingBuffer<int, 4> queue;
+    for (int i = 0; i < 6; i++) {
+      REQUIRE(queue.tryPush(i) == (i < 4));
+    }
+    REQUIRE(queue.dropped() == 2);
+    REQUIRE(queue.tryPop() == 0);
+    REQUIRE(queue.tryPush(4));
+
+    std::vector<int> rest;
+    REQUIRE(queue.drain([&](int i) { rest.push_back(i); }) == 4);
+    REQUIRE(rest == std::vector<int>{1, 2, 3, 4});
+    REQUIRE_FALSE(queue.tryPop());
+  }
+
+  SECTION("AcrossThreads") {
+    constexpr int COUNT = 1'000'000;
+    auto queue = std::make_unique<SpscRingBuffer<int, 256>>();
+    std::thread producer{[&] {
+      for (int i = 0; i < COUNT; i++) {
+        while (not queue->tryPush(i)) {
+          std::this_thread::yield();
+        }
+      }
+    }};
+
+    // Everything arrives, once each and in order
+    int expected = 0;
+    bool inOrder = true;
+    while (expected < COUNT) {
+      queue->drain([&](int i) { inOrder = inOrder and i == expected++; });
+    }
+    producer.join();
+    REQUIRE(inOrder);
+    REQUIRE_FALSE(queue->tryPop());
+  }
+}
+
+TEST_CASE("TetrisEvents") {
+  auto queue = std::make_unique<EventQueue>();
+  auto tetris = TetrisFactory::seededTetris(1);
+  tetris.setEventQueue(queue.get());
+
+  SECTION("LockAndHold") {
+    auto shape = tetris.getCurrentShape();
+    tetris.handleInput(Key::SPACE);
+    auto landed = drain(*queue);
+    REQUIRE(types(landed) ==
+            std::vector<EventType>{EventType::LOCK, EventType::SPAWN});
+    REQUIRE(landed[0].mask == shape.mask());
+    REQUIRE(landed[0].piece == 1);
+    // It's now part of the board, where it says it locked
+    REQUIRE(tetris.getBoard().collides(landed[0].mask, landed[0].x,
+                                       landed[0].y));
+    REQUIRE(landed[1].mask == tetris.getCurrentShape().mask());
+    REQUIRE(landed[1].x == tetris.getShapeLocation().x);
+
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(types(drain(*queue)) ==
+            std::vector<EventType>{EventType::HOLD, EventType::SPAWN});
+    // Holding twice in a turn doesn't do anything
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(drain(*queue).empty());
+  }
+
+  SECTION("Copies") {
+    // A copy isn't a second producer for the queue, but a moved game still
+    // writes to it
+    auto copy = tetris;
+    copy.handleInput(Key::SPACE);
+    REQUIRE(drain(*queue).empty());
+
+    auto moved = std::move(tetris);
+    moved.handleInput(Key::SPACE);
+    REQUIRE(types(drain(*queue)) ==
+            std::vector<EventType>{EventType::LOCK, EventType::SPAWN});
+
+    // Which the game it was moved from no longer does
+    tetris.handleInput(Key::SPACE);
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(drain(*queue).empty());
+
+    // And the same goes for moving a game over another
+    tetris = std::move(moved);
+    moved.handleInput(Key::SPACE);
+    REQUIRE(drain(*queue).empty());
+    tetris.handleInput(Key::SPACE);
+    REQUIRE(types(drain(*queue)) ==
+            std::vector<EventType>{EventType::LOCK, EventType::SPAWN});
+
+    auto other = Tetris<BagShapeFactory>::createTetris(8, 40, BagShapeFactory{1}).value();
+    REQUIRE_THROWS_AS(other = std::move(tetris), std::invalid_argument);
+  }
+
+  SECTION("Clear") {
+    auto state = tetris.snapshot();
+    for (int x = 0; x < 10; x++) {
+      if (x != 3) {
+        state.board.setCellAt(x, 0, true);
+      }
+      if (x != 3 and x != 4) {
+        state.board.setCellAt(x, 1, true);
+      }
+    }
+    state.board.setCellAt(4, 2, true);
+    state.currentShape = StandardShapeFactory::T_BLOCK;
+    state.shapeLocation = {3, 0};
+    state.rotatedLast = true;
+    tetris.restore(state);
+
+    tetris.handleInput(Direction::DOWN);
+    auto events = drain(*queue);
+    REQUIRE(types(events) ==
+            std::vector<EventType>{EventType::LOCK, EventType::CLEAR,
+                                   EventType::SPAWN});
+    REQUIRE(events[0].lock == Lock{2, Spin::FULL});
+    REQUIRE(events[1].rows == 0b11);
+  }
+
+  SECTION("GameOver") {
+    while (not tetris.isToppedOut()) {
+      tetris.handleInput(Key::SPACE);
+    }
+    auto events = drain(*queue);
+    REQUIRE(events.back().type == EventType::GAME_OVER);
+    REQUIRE(events.back().piece == tetris.getPieces());
+    REQUIRE(queue->dropped() == 0);
+  }
+}
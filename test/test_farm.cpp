@@ -0,0 +1,89 @@
+#include "catch2/catch.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "../lib/farm.hpp"
+
+namespace {
+// Goes through the standard shapes in order, starting from wherever the seed
+// says
+struct CycleFactory {
+  mutable std::uint64_t i;
+
+  const Shape getShape() const {
+    return StandardShapeFactory::defaultShapes[i++ % 7];
+  }
+
+  const std::vector<const Shape> getShapes() const {
+    return StandardShapeFactory::defaultShapes;
+  }
+};
+} // namespace
+
+TEST_CASE("WorkStealingPool") {
+  WorkStealingPool pool{4};
+
+  SECTION("RunsEveryTaskOnce") {
+    std::vector<std::atomic<int>> runs(1000);
+    std::atomic<unsigned> maxWorker = 0;
+    pool.parallelFor(1000, [&](int task, unsigned worker) {
+      runs[task]++;
+      for (auto seen = maxWorker.load(); seen < worker and
+                                         not maxWorker.compare_exchange_weak(
+                                             seen, worker);) {
+      }
+    });
+    REQUIRE(std::ranges::all_of(runs, [](auto &r) { return r == 1; }));
+    REQUIRE(maxWorker < pool.size());
+  }
+  SECTION("UnevenTasksAreStolen") {
+    // All the slow tasks start on the first worker
+    std::vector<std::atomic<int>> runs(64);
+    pool.parallelFor(64, [&](int task, unsigned) {
+      if (task < 16) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+      runs[task]++;
+    });
+    REQUIRE(std::ranges::all_of(runs, [](auto &r) { return r == 1; }));
+  }
+  SECTION("RethrowsErrors") {
+    REQUIRE_THROWS_AS(pool.parallelFor(100,
+                                       [](int task, unsigned) {
+                                         if (task == 42) {
+                                           throw std::runtime_error("42");
+                                         }
+                                       }),
+                      std::runtime_error);
+    // The pool is still usable afterwards
+    std::atomic<int> total = 0;
+    pool.parallelFor(10, [&](int, unsigned) { total++; });
+    REQUIRE(total == 10);
+  }
+}
+
+TEST_CASE("PlayGames") {
+  WorkStealingPool pool{4};
+  auto makeFactory = [](std::uint64_t seed) { return CycleFactory{seed}; };
+
+  std::vector<Input> drops(200, Key::SPACE);
+  std::vector<Input> lefts{Direction::LEFT, Direction::LEFT, Key::SPACE};
+  std::vector<FarmGame> games;
+  for (std::uint64_t seed = 0; seed < 50; seed++) {
+    games.push_back({seed, seed % 2 ? std::span<const Input>(drops)
+                                    : std::span<const Input>(lefts)});
+  }
+
+  auto results = playGames<CycleFactory>(pool, games, makeFactory);
+
+  REQUIRE(results.size() == games.size());
+  for (size_t i = 0; i < games.size(); i++) {
+    Simulator<CycleFactory> simulator{makeFactory(games[i].seed)};
+    auto expected = simulator.run(games[i].inputs);
+    REQUIRE(results[i].inputs == expected.inputs);
+    REQUIRE(results[i].pieces == expected.pieces);
+    REQUIRE(results[i].lines == expected.lines);
+    REQUIRE(results[i].toppedOut == expected.toppedOut);
+  }
+}
@@ -0,0 +1,88 @@
+#include "catch2/catch.hpp"
+#include <memory>
+
+#include "../lib/tetris.hpp"
+
+TEST_CASE("GameOver") {
+  auto tetris = TetrisFactory::seededTetris(1);
+  REQUIRE(tetris.getStatus() == GameStatus::PLAYING);
+
+  SECTION("BlockOut") {
+    // Dropping straight down piles shapes up until one can't spawn
+    int drops = 0;
+    while (not tetris.isToppedOut()) {
+      tetris.handleInput(Key::SPACE);
+      drops++;
+      REQUIRE(drops < 100);
+    }
+    REQUIRE(tetris.getStatus() == GameStatus::BLOCKED_OUT);
+    REQUIRE(tetris.getBoard().collides(tetris.getCurrentShape().mask(),
+                                       tetris.getShapeLocation().x,
+                                       tetris.getShapeLocation().y));
+
+    // Nothing changes the game once it's over
+    auto pieces = tetris.getPieces();
+    auto hash = tetris.hash();
+    tetris.handleInput(Key::SPACE);
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(tetris.getPieces() == pieces);
+    REQUIRE(tetris.hash() == hash);
+  }
+
+  SECTION("LockOut") {
+    // An O resting on a tower that goes past the skyline, out to the side of
+    // where shapes spawn
+    auto state = tetris.snapshot();
+    auto top = skyline(state.board) + 5;
+    for (int y = 0; y < top; y++) {
+      state.board.setCellAt(1, y, true);
+    }
+    state.currentShape = StandardShapeFactory::O_BLOCK;
+    state.shapeLocation = {0, top - 1};
+    tetris.restore(state);
+
+    auto queue = std::make_unique<EventQueue>();
+    tetris.setEventQueue(queue.get());
+    tetris.handleInput(Direction::DOWN);
+    REQUIRE(tetris.getStatus() == GameStatus::LOCKED_OUT);
+    REQUIRE(tetris.getPieces() == 1);
+
+    std::vector<EventType> types;
+    queue->drain([&](const GameEvent &event) { types.push_back(event.type); });
+    REQUIRE(types ==
+            std::vector<EventType>{EventType::LOCK, EventType::GAME_OVER});
+  }
+}
+
+TEST_CASE("Reset") {
+  auto tetris = TetrisFactory::seededTetris(1);
+  auto queue = std::make_unique<EventQueue>();
+  tetris.setEventQueue(queue.get());
+  while (not tetris.isToppedOut()) {
+    tetris.handleInput(Rotation::CLOCKWISE);
+    tetris.handleInput(Key::HOLD);
+    tetris.handleInput(Key::SPACE);
+  }
+  queue->drain([](const GameEvent &) {});
+
+  tetris.reset(BagShapeFactory{2});
+  auto fresh = TetrisFactory::seededTetris(2);
+  REQUIRE(tetris.getStatus() == GameStatus::PLAYING);
+  REQUIRE(tetris.getPieces() == 0);
+  REQUIRE(tetris.getScore() == 0);
+  REQUIRE(tetris.getLevel() == 1);
+  REQUIRE_FALSE(tetris.getHoldShape());
+  REQUIRE(tetris.hash() == fresh.hash());
+
+  // The new game starts with a spawn, and plays out like a new one would
+  auto first = queue->tryPop();
+  REQUIRE(first);
+  REQUIRE(first->type == EventType::SPAWN);
+  for (int i = 0; i < 30; i++) {
+    Input input = i % 3 ? Input{Direction::LEFT} : Input{Key::SPACE};
+    tetris.handleInput(input);
+    fresh.handleInput(input);
+    REQUIRE(tetris.hash() == fresh.hash());
+  }
+  REQUIRE(tetris.getScore() == fresh.getScore());
+}
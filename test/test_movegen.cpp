@@ -0,0 +1,115 @@
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "../lib/movegen.hpp"
+
+namespace {
+// Always deals the same shape
+template <const Shape &shape> struct SameShapeFactory {
+  const Shape getShape() const { return shape; }
+
+  const std::vector<const Shape> getShapes() const { return {shape}; }
+};
+
+// The board cells a shape would fill at a placement
+std::set<Coord> cellsAt(Shape shape, const Placement &placement) {
+  shape.rotationIndex = placement.rotationIndex;
+  std::set<Coord> cells;
+  for (auto c : shape.coords()) {
+    cells.insert(c + placement.location);
+  }
+  return cells;
+}
+} // namespace
+
+TEST_CASE("MoveGeneratorEmptyBoard") {
+  auto generator = std::make_unique<MoveGenerator>();
+  Board board{10, 40};
+  Coord spawn{3, 16};
+
+  auto count = [&](const Shape &shape) {
+    return generator->generate(board, shape, spawn).size();
+  };
+  REQUIRE(count(StandardShapeFactory::O_BLOCK) == 9);
+  REQUIRE(count(StandardShapeFactory::I_BLOCK) == 17);
+  REQUIRE(count(StandardShapeFactory::S_BLOCK) == 17);
+  REQUIRE(count(StandardShapeFactory::Z_BLOCK) == 17);
+  REQUIRE(count(StandardShapeFactory::T_BLOCK) == 34);
+  REQUIRE(count(StandardShapeFactory::L_BLOCK) == 34);
+  REQUIRE(count(StandardShapeFactory::J_BLOCK) == 34);
+}
+
+TEST_CASE("MoveGeneratorTucks") {
+  auto generator = std::make_unique<MoveGenerator>();
+  Board board{10, 40};
+  // A shelf over the left of the board, with the bottom two rows open below
+  for (int x = 0; x < 8; x++) {
+    board.setCellAt(x, 2, true);
+  }
+
+  auto placements =
+      generator->generate(board, StandardShapeFactory::O_BLOCK, {3, 16});
+  std::set<Coord> underShelf{{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+  REQUIRE(std::ranges::any_of(placements, [&](auto &placement) {
+    return cellsAt(StandardShapeFactory::O_BLOCK, placement) == underShelf;
+  }));
+}
+
+TEST_CASE("MoveGeneratorCaves") {
+  auto generator = std::make_unique<MoveGenerator>();
+  Board board{10, 40};
+  // A stack with a well down to the floor, and a cave off the side of the well
+  // halfway down that can only be shifted into on the way down
+  std::set<Coord> cave{{6, 3}, {7, 3}, {6, 4}, {7, 4}};
+  for (int y = 0; y < 8; y++) {
+    for (int x = 0; x < 10; x++) {
+      if (x != 4 and x != 5 and not cave.contains({x, y})) {
+        board.setCellAt(x, y, true);
+      }
+    }
+  }
+
+  auto placements =
+      generator->generate(board, StandardShapeFactory::O_BLOCK, {3, 16});
+  REQUIRE(std::ranges::any_of(placements, [&](auto &placement) {
+    return cellsAt(StandardShapeFactory::O_BLOCK, placement) == cave;
+  }));
+}
+
+TEST_CASE("MoveGeneratorInputs") {
+  auto generator = std::make_unique<MoveGenerator>();
+  using Factory = SameShapeFactory<StandardShapeFactory::T_BLOCK>;
+  auto tetris = Tetris<Factory>::createTetris(10, 40, {}).value();
+
+  // Build up some stack to move around
+  for (auto input : {Input{Direction::LEFT}, Input{Key::SPACE},
+                     Input{Rotation::CLOCKWISE}, Input{Key::SPACE},
+                     Input{Direction::RIGHT}, Input{Direction::RIGHT},
+                     Input{Direction::RIGHT}, Input{Key::SPACE}}) {
+    tetris.handleInput(input);
+  }
+
+  auto placements = generator->generate(tetris);
+  REQUIRE(placements.size() > 0);
+
+  std::vector<Input> inputs;
+  for (auto &placement : placements) {
+    auto copy = tetris;
+    auto expected = tetris.getBoard();
+    auto shape = tetris.getCurrentShape();
+    shape.rotationIndex = placement.rotationIndex;
+    expected.place(shape.mask(), placement.location.x, placement.location.y);
+
+    inputs.clear();
+    generator->inputsFor(placement, inputs);
+    for (auto input : inputs) {
+      copy.handleInput(input);
+    }
+    REQUIRE(copy.getPieces() == tetris.getPieces() + 1);
+    REQUIRE(std::ranges::equal(copy.getBoard().usedRows(),
+                               expected.usedRows()));
+  }
+}
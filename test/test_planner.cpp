@@ -0,0 +1,111 @@
+#include "catch2/catch.hpp"
+#include <memory>
+#include <vector>
+
+#include "../lib/parallel_planner.hpp"
+
+TEST_CASE("PlannerPlaysGames") {
+  auto planner = std::make_unique<Planner>();
+  auto tetris = TetrisFactory::seededTetris(2024);
+  SearchLimits limits{.depth = 2, .beamWidth = 16};
+
+  std::vector<Input> inputs;
+  for (int piece = 0; piece < 200; piece++) {
+    auto move = planner->plan(tetris, limits);
+    REQUIRE(move);
+    REQUIRE(planner->stats().depthReached == 2);
+
+    inputs.clear();
+    planner->inputsFor(tetris, *move, inputs);
+    auto pieces = tetris.getPieces();
+    for (auto input : inputs) {
+      tetris.handleInput(input);
+    }
+    REQUIRE(tetris.getPieces() == pieces + 1);
+    REQUIRE_FALSE(tetris.isToppedOut());
+  }
+  REQUIRE(tetris.getLines() >= 60);
+}
+
+TEST_CASE("PlannerLimits") {
+  auto planner = std::make_unique<Planner>();
+  auto tetris = TetrisFactory::seededTetris(7);
+
+  SECTION("Nodes") {
+    auto move = planner->plan(tetris, {.depth = 6, .nodes = 100});
+    REQUIRE(move);
+    // The budget is checked between expansions, which evaluate at most a
+    // couple of shapes' worth of placements
+    REQUIRE(planner->stats().nodes < 100 + 2 * 34);
+    REQUIRE(planner->stats().depthReached < 6);
+  }
+  SECTION("Time") {
+    auto move = planner->plan(
+        tetris, {.depth = 6, .time = std::chrono::nanoseconds::zero()});
+    REQUIRE(move);
+    REQUIRE(planner->stats().depthReached == 0);
+  }
+  SECTION("Stats") {
+    planner->plan(tetris, {.depth = 3});
+    REQUIRE(planner->stats().depthReached == 3);
+    REQUIRE(planner->stats().nodes > 0);
+    REQUIRE(planner->stats().nodesPerSecond() > 0);
+  }
+}
+
+TEST_CASE("ParallelPlannerPlaysGames") {
+  WorkStealingPool pool{4};
+  auto planner = std::make_unique<ParallelPlanner>(pool);
+  auto tetris = TetrisFactory::seededTetris(2024);
+  SearchLimits limits{.depth = 3, .beamWidth = 4};
+
+  std::vector<Input> inputs;
+  for (int piece = 0; piece < 100; piece++) {
+    auto move = planner->plan(tetris, limits);
+    REQUIRE(move);
+    REQUIRE(planner->stats().depthReached == 3);
+
+    inputs.clear();
+    planner->inputsFor(tetris, *move, inputs);
+    auto pieces = tetris.getPieces();
+    for (auto input : inputs) {
+      tetris.handleInput(input);
+    }
+    REQUIRE(tetris.getPieces() == pieces + 1);
+    REQUIRE_FALSE(tetris.isToppedOut());
+  }
+  REQUIRE(tetris.getLines() >= 30);
+}
+
+TEST_CASE("ParallelPlannerLimits") {
+  WorkStealingPool pool{4};
+  auto planner = std::make_unique<ParallelPlanner>(pool);
+  auto tetris = TetrisFactory::seededTetris(7);
+
+  REQUIRE(planner->plan(tetris, {.depth = 6, .nodes = 1000}));
+  REQUIRE(planner->stats().depthReached < 6);
+  REQUIRE(planner->stats().nodes < 2000);
+}
+
+TEST_CASE("TranspositionTableOwners") {
+  TranspositionTable table{8};
+  table.newSearch();
+  REQUIRE(table.admit(42, 2, 5.0f, 1) == 5.0f);
+
+  SECTION("SameSearch") {
+    REQUIRE_FALSE(table.admit(42, 2, 4.0f, 1));
+    REQUIRE(table.admit(42, 2, 6.0f, 1) == 6.0f);
+  }
+  SECTION("OtherSearch") {
+    // Another search meeting the same state carries on with its value
+    REQUIRE(table.admit(42, 2, 4.0f, 2) == 5.0f);
+    REQUIRE(table.admit(42, 2, 6.0f, 2) == 6.0f);
+  }
+  SECTION("OtherDepth") {
+    REQUIRE(table.admit(42, 3, 4.0f, 1) == 4.0f);
+  }
+  SECTION("NewSearch") {
+    table.newSearch();
+    REQUIRE(table.admit(42, 2, 4.0f, 1) == 4.0f);
+  }
+}
@@ -0,0 +1,98 @@
+#include "catch2/catch.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "../lib/renderer.hpp"
+
+namespace {
+std::atomic<long> allocations = 0;
+
+// Rows redrawn by a frame, as the number of times it moves the cursor to the
+// first column
+int rowsDrawn(std::string_view frame) {
+  int rows = 0;
+  for (auto pos = frame.find(";1H"); pos != std::string_view::npos;
+       pos = frame.find(";1H", pos + 1)) {
+    rows++;
+  }
+  return rows;
+}
+} // namespace
+
+// Counts every allocation this test makes
+void *operator new(std::size_t size) {
+  allocations++;
+  if (auto p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+TEST_CASE("TerminalRenderer") {
+  auto tetris = TetrisFactory::seededTetris(1);
+  TerminalRenderer renderer;
+
+  auto first = std::string(renderer.render(tetris));
+  REQUIRE(first.starts_with("\x1b[2J"));
+  // Every visible row, the floor and the status line
+  REQUIRE(rowsDrawn(first) == TerminalRenderer::VISIBLE_ROWS + 2);
+  REQUIRE(first.find("Score 0  Lines 0  Level 1") != std::string::npos);
+
+  SECTION("OnlyChangedRows") {
+    REQUIRE(renderer.render(tetris).empty());
+
+    // Moving sideways only changes the rows the shape is in
+    auto shape = tetris.getCurrentShape();
+    tetris.handleInput(Direction::LEFT);
+    auto moved = renderer.render(tetris);
+    int shapeRows = 0;
+    for (int r = 0; r < PIECE_MASK_SIZE; r++) {
+      shapeRows += pieceRow(shape.mask(), r) != 0;
+    }
+    REQUIRE(rowsDrawn(moved) == shapeRows);
+    REQUIRE(moved.find("\x1b[2J") == std::string_view::npos);
+
+    // Dropping it changes the score too
+    tetris.handleInput(Key::SPACE);
+    auto dropped = renderer.render(tetris);
+    REQUIRE(dropped.find("Score ") != std::string_view::npos);
+    REQUIRE(rowsDrawn(dropped) > 1);
+  }
+
+  SECTION("Invalidate") {
+    renderer.invalidate();
+    REQUIRE(renderer.render(tetris) == first);
+  }
+
+  SECTION("NoAllocations") {
+    auto before = allocations.load();
+    std::size_t bytes = 0;
+    for (int frame = 0; frame < 600; frame++) {
+      tetris.handleInput(frame % 7 ? Input{Direction::DOWN}
+                                   : Input{Rotation::CLOCKWISE});
+      bytes += renderer.render(tetris).size();
+    }
+    REQUIRE(allocations.load() == before);
+    REQUIRE(bytes > 0);
+  }
+
+  SECTION("Draw") {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    renderer.invalidate();
+    REQUIRE(renderer.draw(tetris, fds[1]));
+    ::close(fds[1]);
+
+    std::string written;
+    char chunk[256];
+    for (ssize_t n; (n = ::read(fds[0], chunk, sizeof(chunk))) > 0;) {
+      written.append(chunk, n);
+    }
+    ::close(fds[0]);
+    REQUIRE(written == first);
+  }
+}
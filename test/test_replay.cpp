@@ -0,0 +1,96 @@
+#include "catch2/catch.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../lib/replay.hpp"
+
+namespace {
+std::vector<std::uint8_t> bytesOf(const std::ostringstream &out) {
+  auto string = out.str();
+  return {string.begin(), string.end()};
+}
+
+// Events a frame or few apart, with the occasional long pause
+std::vector<ReplayEvent> someEvents(int count) {
+  std::vector<ReplayEvent> events;
+  Xoshiro256 rng{8};
+  std::uint64_t frame = 0;
+  for (int i = 0; i < count; i++) {
+    frame += rng.below(10) == 0 ? 1000 : rng.below(6);
+    events.push_back({frame, *ReplayFormat::codeInput(rng.below(7))});
+  }
+  return events;
+}
+} // namespace
+
+TEST_CASE("ReplayRoundTrip") {
+  ReplayHeader header{.seed = 0xfeedbeef, .width = 10, .height = 40};
+  auto events = someEvents(1000);
+
+  std::ostringstream out;
+  {
+    ReplayWriter writer{out, header};
+    for (auto &event : events) {
+      writer.record(event.frame, event.input);
+    }
+  }
+  auto bytes = bytesOf(out);
+  // Nearly every event fits in a byte
+  REQUIRE(bytes.size() < events.size() * 5 / 4);
+
+  auto reader = ReplayReader::open(bytes).value();
+  REQUIRE(reader.getHeader() == header);
+  std::vector<ReplayEvent> read;
+  while (auto event = reader.next().value()) {
+    read.push_back(*event);
+  }
+  REQUIRE(read == events);
+  REQUIRE(reader.position() == bytes.size());
+}
+
+TEST_CASE("ReplayPlaysBack") {
+  ReplayHeader header{.seed = 77};
+  auto tetris = startReplay<BagShapeFactory>(header).value();
+  auto events = someEvents(500);
+
+  std::ostringstream out;
+  ReplayWriter writer{out, header};
+  for (auto &event : events) {
+    writer.record(event.frame, event.input);
+    tetris.handleInput(event.input);
+  }
+  writer.finish();
+
+  auto bytes = bytesOf(out);
+  auto reader = ReplayReader::open(bytes).value();
+  auto replayed = startReplay<BagShapeFactory>(reader.getHeader()).value();
+  REQUIRE(playReplay(reader, replayed).value() == (int)events.size());
+  REQUIRE(replayed.hash() == tetris.hash());
+  REQUIRE(replayed.getPieces() == tetris.getPieces());
+}
+
+TEST_CASE("ReplayErrors") {
+  std::ostringstream out;
+  {
+    ReplayWriter writer{out, {}};
+    writer.record(5, Key::SPACE);
+    REQUIRE_THROWS_AS(writer.record(4, Key::SPACE), std::invalid_argument);
+  }
+  auto bytes = bytesOf(out);
+
+  SECTION("Truncated") {
+    bytes.pop_back();
+    auto reader = ReplayReader::open(bytes).value();
+    REQUIRE(reader.next().value());
+    REQUIRE(reader.next().error() == ReplayError::TRUNCATED);
+  }
+  SECTION("BadMagic") {
+    bytes[0] = 'X';
+    REQUIRE(ReplayReader::open(bytes).error() == ReplayError::BAD_MAGIC);
+  }
+  SECTION("BadVersion") {
+    bytes[4] = 99;
+    REQUIRE(ReplayReader::open(bytes).error() == ReplayError::BAD_VERSION);
+  }
+}
@@ -0,0 +1,77 @@
+#include "catch2/catch.hpp"
+#include <memory>
+#include <vector>
+
+#include "../lib/rollback.hpp"
+
+namespace {
+using Game = Rollback<BagShapeFactory, 16>;
+
+// A few frames' worth of inputs that place some shapes
+std::vector<std::vector<Input>> someFrames() {
+  std::vector<std::vector<Input>> frames;
+  for (int i = 0; i < 60; i++) {
+    switch (i % 5) {
+    case 0:
+      frames.push_back({Direction::LEFT, Rotation::CLOCKWISE});
+      break;
+    case 2:
+      frames.push_back({Direction::RIGHT});
+      break;
+    case 4:
+      frames.push_back({Key::SPACE});
+      break;
+    default:
+      frames.push_back({});
+    }
+  }
+  return frames;
+}
+} // namespace
+
+TEST_CASE("Rollback") {
+  auto frames = someFrames();
+  auto rollback = std::make_unique<Game>(TetrisFactory::seededTetris(3));
+
+  // The same inputs played straight through, with nothing late
+  auto expected = TetrisFactory::seededTetris(3);
+  for (auto &inputs : frames) {
+    for (auto input : inputs) {
+      expected.handleInput(input);
+    }
+  }
+
+  SECTION("LateInputs") {
+    // Each frame's inputs arrive four frames late, so until then nothing is
+    // guessed to have happened
+    constexpr int DELAY = 4;
+    for (int frame = 0; frame < (int)frames.size() + DELAY; frame++) {
+      if (frame < (int)frames.size()) {
+        REQUIRE(rollback->advance({}));
+      }
+      if (int late = frame - DELAY; late >= 0) {
+        auto replayed = rollback->correct(late, frames[late]);
+        REQUIRE(replayed);
+        REQUIRE(*replayed ==
+                (frames[late].empty() ? 0 : rollback->frame() - late));
+      }
+    }
+    REQUIRE(rollback->getTetris().hash() == expected.hash());
+    REQUIRE(rollback->getTetris().getPieces() == expected.getPieces());
+  }
+  SECTION("Errors") {
+    std::vector<Input> tooMany(Game::MAX_FRAME_INPUTS + 1, Direction::LEFT);
+    REQUIRE(rollback->advance(tooMany).error() ==
+            Game::RollbackError::TOO_MANY_INPUTS);
+    REQUIRE(rollback->correct(0, {}).error() ==
+            Game::RollbackError::FRAME_NOT_PLAYED);
+
+    for (int frame = 0; frame < 20; frame++) {
+      REQUIRE(rollback->advance({}));
+    }
+    REQUIRE(rollback->oldestFrame() == 4);
+    REQUIRE(rollback->correct(3, {}).error() ==
+            Game::RollbackError::FRAME_TOO_OLD);
+    REQUIRE(rollback->correct(4, {}).value() == 0);
+  }
+}
@@ -0,0 +1,147 @@
+#include "catch2/catch.hpp"
+
+#include "../lib/tetris.hpp"
+
+TEST_CASE("ScoringChains") {
+  ScoreChain chain;
+  SECTION("Combo") {
+    REQUIRE(scoring::award(chain, {1, Spin::NONE}, 1) == 100);
+    REQUIRE(scoring::award(chain, {1, Spin::NONE}, 1) == 150);
+    REQUIRE(scoring::award(chain, {2, Spin::NONE}, 1) == 400);
+    REQUIRE(chain.combo == 2);
+    REQUIRE(scoring::award(chain, {0, Spin::NONE}, 1) == 0);
+    REQUIRE(chain.combo == -1);
+  }
+
+  SECTION("BackToBack") {
+    REQUIRE(scoring::award(chain, {4, Spin::NONE}, 2) == 1600);
+    // A lock that clears nothing doesn't break the chain
+    REQUIRE(scoring::award(chain, {0, Spin::MINI}, 2) == 200);
+    REQUIRE(scoring::award(chain, {2, Spin::FULL}, 2) == 3600);
+    REQUIRE(chain.backToBack);
+    // Nor does a combo count towards it
+    REQUIRE(scoring::award(chain, {1, Spin::NONE}, 2) == 300);
+    REQUIRE_FALSE(chain.backToBack);
+    REQUIRE(scoring::award(chain, {4, Spin::NONE}, 2) == 1800);
+  }
+
+  REQUIRE(scoring::levelFor(0) == 1);
+  REQUIRE(scoring::levelFor(9) == 1);
+  REQUIRE(scoring::levelFor(25) == 3);
+}
+
+TEST_CASE("TSpinCorners") {
+  // This T stands upright with its centre at (3, 1), pointing right, so the
+  // corners in front of it are (4, 0) and (4, 2)
+  auto t = StandardShapeFactory::T_BLOCK.mask();
+  Board board{10, 20};
+  auto spin = [&](bool rotated = true, bool kickedLast = false) {
+    return scoring::tSpin(board, t, 3, 0, rotated, kickedLast);
+  };
+
+  board.setCellAt(2, 0, true);
+  board.setCellAt(4, 0, true);
+  REQUIRE(spin() == Spin::NONE);
+
+  SECTION("Full") {
+    board.setCellAt(4, 2, true);
+    REQUIRE(spin() == Spin::FULL);
+    REQUIRE(spin(false) == Spin::NONE);
+  }
+
+  SECTION("Mini") {
+    board.setCellAt(2, 2, true);
+    REQUIRE(spin() == Spin::MINI);
+    REQUIRE(spin(true, true) == Spin::FULL);
+  }
+
+  SECTION("Walls") {
+    // Past the left wall counts as filled
+    REQUIRE(scoring::tSpin(board, t, -1, 0, true, false) == Spin::NONE);
+    REQUIRE(scoring::tSpin(board, t, 0, 0, true, false) == Spin::NONE);
+    board.setCellAt(1, 0, true);
+    REQUIRE(scoring::tSpin(board, t, 0, 0, true, false) == Spin::MINI);
+  }
+
+  // Every way round, a T buried in filled cells is a full spin -- and one in
+  // the open isn't
+  auto shape = StandardShapeFactory::T_BLOCK;
+  for (int rotation = 0; rotation < 4; rotation++) {
+    Board buried{10, 20};
+    for (int y = 2; y < 7; y++) {
+      for (int x = 2; x < 7; x++) {
+        buried.setCellAt(x, y, true);
+      }
+    }
+    for (auto c : shape.coords()) {
+      buried.setCellAt(3 + c.x, 3 + c.y, false);
+    }
+    REQUIRE(scoring::tSpin(buried, shape.mask(), 3, 3, true, false) ==
+            Spin::FULL);
+    REQUIRE(scoring::tSpin(Board{10, 20}, shape.mask(), 3, 3, true, false) ==
+            Spin::NONE);
+    shape = shape.rotateClockwise();
+  }
+}
+
+TEST_CASE("TetrisScoring") {
+  auto tetris = TetrisFactory::seededTetris(1);
+
+  SECTION("HardDrop") {
+    auto distance = tetris.getBoard().dropDistance(
+        tetris.getCurrentShape().mask(), tetris.getShapeLocation().x,
+        tetris.getShapeLocation().y);
+    tetris.handleInput(Key::SPACE);
+    REQUIRE(tetris.getScore() == scoring::HARD_DROP * distance);
+    REQUIRE(tetris.getLastLock() == Lock{0, Spin::NONE});
+  }
+
+  SECTION("TSpinDouble") {
+    // A T that's just been spun into a slot that's one cell short of
+    // clearing the bottom two rows
+    auto state = tetris.snapshot();
+    for (int x = 0; x < 10; x++) {
+      if (x != 3) {
+        state.board.setCellAt(x, 0, true);
+      }
+      if (x != 3 and x != 4) {
+        state.board.setCellAt(x, 1, true);
+      }
+    }
+    state.board.setCellAt(4, 2, true);
+    state.currentShape = StandardShapeFactory::T_BLOCK;
+    state.shapeLocation = {3, 0};
+    state.rotatedLast = true;
+    tetris.restore(state);
+
+    tetris.handleInput(Direction::DOWN);
+    REQUIRE(tetris.getLastLock() == Lock{2, Spin::FULL});
+    REQUIRE(tetris.getLines() == 2);
+    REQUIRE(tetris.getScore() == 1200);
+    REQUIRE(tetris.getCombo() == 0);
+    REQUIRE(tetris.isBackToBack());
+  }
+
+  SECTION("TwoRowKickMini") {
+    // A T kicked up two rows by the third of its kicks -- not the last one,
+    // so the mini it lands in isn't upgraded
+    //
+    //   . x . x .
+    //   . T T T .
+    //   . x T . .
+    //   . . x . .
+    //   . . . . x
+    auto state = tetris.snapshot();
+    for (auto [x, y] : {std::pair{7, 1}, {5, 2}, {4, 3}, {4, 5}, {6, 5}}) {
+      state.board.setCellAt(x, y, true);
+    }
+    state.currentShape = StandardShapeFactory::T_BLOCK;
+    state.shapeLocation = {4, 0};
+    tetris.restore(state);
+
+    tetris.handleInput(Rotation::CLOCKWISE);
+    REQUIRE(tetris.getShapeLocation() == Coord{4, 2});
+    tetris.handleInput(Direction::DOWN);
+    REQUIRE(tetris.getLastLock() == Lock{0, Spin::MINI});
+  }
+}
@@ -6,7 +6,7 @@
 #include "../lib/tetris.hpp"
 
 std::ostream &operator<<(std::ostream &stream, Shape &shape) {
-  std::vector<Coord> coordsCopy{shape.coords};
+  std::vector<Coord> coordsCopy{shape.coords()};
   std::ranges::sort(coordsCopy);
 
   auto cIter = coordsCopy.begin();
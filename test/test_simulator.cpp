@@ -0,0 +1,54 @@
+#include "catch2/catch.hpp"
+#include <vector>
+
+#include "../lib/simulator.hpp"
+
+namespace {
+struct IBlockFactory {
+  const Shape getShape() const { return StandardShapeFactory::I_BLOCK; }
+
+  const std::vector<const Shape> getShapes() const {
+    return {StandardShapeFactory::I_BLOCK};
+  }
+};
+} // namespace
+
+TEST_CASE("SimulatorRun") {
+  Simulator simulator{IBlockFactory()};
+
+  SECTION("StopsAtTopOut") {
+    // Dropping straight down stacks every I block in the same four columns,
+    // until one can't spawn
+    std::vector<Input> inputs(100, Key::SPACE);
+    auto stats = simulator.run(inputs);
+
+    REQUIRE(stats.toppedOut);
+    REQUIRE(stats.pieces == 18);
+    REQUIRE(stats.inputs == 18);
+    REQUIRE(stats.lines == 0);
+  }
+  SECTION("CountsClears") {
+    // Fill the bottom row with I blocks at the left, middle, and a vertical
+    // pair on the right
+    std::vector<Input> inputs{Direction::LEFT, Direction::LEFT,
+                              Direction::LEFT, Key::SPACE,
+                              Direction::RIGHT, Key::SPACE,
+                              Rotation::CLOCKWISE};
+    for (int i = 0; i < 10; i++) {
+      inputs.push_back(Direction::RIGHT);
+    }
+    inputs.push_back(Key::SPACE);
+    inputs.push_back(Rotation::CLOCKWISE);
+    for (int i = 0; i < 10; i++) {
+      inputs.push_back(Direction::RIGHT);
+    }
+    inputs.push_back(Direction::LEFT);
+    inputs.push_back(Key::SPACE);
+
+    auto stats = simulator.run(inputs);
+    REQUIRE_FALSE(stats.toppedOut);
+    REQUIRE(stats.pieces == 4);
+    REQUIRE(stats.lines == 1);
+    REQUIRE(stats.inputs == (int)inputs.size());
+  }
+}
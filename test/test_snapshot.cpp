@@ -0,0 +1,76 @@
+#include "catch2/catch.hpp"
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../lib/tetris.hpp"
+
+static_assert(std::is_trivially_copyable_v<GameState<BagShapeFactory>>);
+static_assert(std::is_trivially_copyable_v<GameState<StandardShapeFactory>>);
+
+namespace {
+std::vector<Input> someInputs(int count) {
+  std::vector<Input> inputs;
+  Xoshiro256 rng{3};
+  for (int i = 0; i < count; i++) {
+    switch (rng.below(6)) {
+    case 0:
+      inputs.push_back(Direction::LEFT);
+      break;
+    case 1:
+      inputs.push_back(Direction::RIGHT);
+      break;
+    case 2:
+      inputs.push_back(Rotation::CLOCKWISE);
+      break;
+    case 3:
+      inputs.push_back(Key::HOLD);
+      break;
+    default:
+      inputs.push_back(Key::SPACE);
+    }
+  }
+  return inputs;
+}
+} // namespace
+
+TEST_CASE("GameStateSnapshot") {
+  auto tetris = TetrisFactory::seededTetris(11);
+  // Enough inputs to top out, from a snapshot taken while still in play
+  auto inputs = someInputs(400);
+  for (auto input : std::span(inputs).first(10)) {
+    tetris.handleInput(input);
+  }
+
+  GameState<BagShapeFactory> snapshot = tetris.snapshot();
+  auto replay = [&] {
+    std::vector<std::uint64_t> hashes;
+    for (auto input : std::span(inputs).subspan(10)) {
+      tetris.handleInput(input);
+      hashes.push_back(tetris.hash());
+    }
+    hashes.push_back((std::uint64_t)tetris.getPieces());
+    hashes.push_back((std::uint64_t)tetris.getLines());
+    return hashes;
+  };
+
+  // Playing on from a restored snapshot deals the same shapes and ends up in
+  // the same places
+  auto first = replay();
+  REQUIRE(snapshot.hash() != tetris.hash());
+  tetris.restore(snapshot);
+  REQUIRE(replay() == first);
+
+  SECTION("RestoringItself") {
+    tetris.restore(snapshot);
+    tetris.restore(tetris.snapshot());
+    REQUIRE(replay() == first);
+  }
+
+  SECTION("OtherSizesAreRejected") {
+    auto other =
+        Tetris<BagShapeFactory>::createTetris(8, 40, BagShapeFactory{1})
+            .value();
+    REQUIRE_THROWS_AS(other.restore(snapshot), std::invalid_argument);
+  }
+}
@@ -0,0 +1,99 @@
+#include "catch2/catch.hpp"
+#include <string_view>
+#include <vector>
+
+#include "../lib/terminal.hpp"
+
+namespace {
+std::vector<TerminalKey> parse(KeyParser &parser, std::string_view bytes) {
+  std::vector<TerminalKey> keys;
+  for (auto byte : bytes) {
+    parser.feed(byte, [&](TerminalKey key) { keys.push_back(key); });
+  }
+  return keys;
+}
+
+TerminalKey character(char c) { return {KeyCode::CHARACTER, c}; }
+} // namespace
+
+TEST_CASE("KeyParser") {
+  KeyParser parser;
+
+  SECTION("Arrows") {
+    // Both the normal and application cursor key sequences
+    REQUIRE(parse(parser, "\x1b[A\x1b[B\x1b[C\x1b[D\x1bOD") ==
+            std::vector<TerminalKey>{{KeyCode::UP},
+                                     {KeyCode::DOWN},
+                                     {KeyCode::RIGHT},
+                                     {KeyCode::LEFT},
+                                     {KeyCode::LEFT}});
+  }
+
+  SECTION("SplitAcrossReads") {
+    REQUIRE(parse(parser, "q\x1b").size() == 1);
+    REQUIRE(parse(parser, "[").empty());
+    REQUIRE(parse(parser, "C ") ==
+            std::vector<TerminalKey>{{KeyCode::RIGHT}, character(' ')});
+  }
+
+  SECTION("OtherSequencesIgnored") {
+    // Delete, then shift and right
+    REQUIRE(parse(parser, "\x1b[3~\x1b[1;2Cx") ==
+            std::vector<TerminalKey>{{KeyCode::RIGHT}, character('x')});
+  }
+
+  SECTION("Escape") {
+    REQUIRE(parse(parser, "\x1b").empty());
+    std::vector<TerminalKey> flushed;
+    parser.flush([&](TerminalKey key) { flushed.push_back(key); });
+    REQUIRE(flushed == std::vector<TerminalKey>{{KeyCode::ESCAPE}});
+
+    // Or a key straight after the ESC, as alt sends
+    REQUIRE(parse(parser, "\x1b"
+                          "c") ==
+            std::vector<TerminalKey>{{KeyCode::ESCAPE}, character('c')});
+  }
+}
+
+TEST_CASE("TerminalInput") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  REQUIRE(RawTerminal::open(fds[0]).error() == TerminalError::NOT_A_TERMINAL);
+
+  TerminalInput input{fds[0]};
+  std::vector<TerminalKey> keys;
+  auto onKey = [&](TerminalKey key) { keys.push_back(key); };
+
+  // Nothing there yet, so it gives up after the timeout
+  REQUIRE(input.poll(std::chrono::milliseconds{1}, onKey));
+  REQUIRE(keys.empty());
+
+  std::string_view typed = "\x1b[D \x1b";
+  REQUIRE(::write(fds[1], typed.data(), typed.size()) == (ssize_t)typed.size());
+  REQUIRE(input.poll(std::chrono::milliseconds{100}, onKey));
+  REQUIRE(keys == std::vector<TerminalKey>{{KeyCode::LEFT}, character(' ')});
+  // The ESC on the end is only a key once nothing has followed it for a
+  // while, however often it's polled without waiting in the meantime
+  REQUIRE(input.poll(std::chrono::milliseconds{0}, onKey));
+  REQUIRE(keys.size() == 2);
+  REQUIRE(input.poll(TerminalInput::ESCAPE_TIMEOUT, onKey));
+  REQUIRE(keys.back() == TerminalKey{KeyCode::ESCAPE});
+
+  SECTION("SplitSequence") {
+    keys.clear();
+    typed = "\x1b";
+    REQUIRE(::write(fds[1], typed.data(), typed.size()) == 1);
+    REQUIRE(input.poll(std::chrono::milliseconds{100}, onKey));
+    for (int i = 0; i < 3; i++) {
+      REQUIRE(input.poll(std::chrono::milliseconds{0}, onKey));
+    }
+    typed = "[A";
+    REQUIRE(::write(fds[1], typed.data(), typed.size()) == 2);
+    REQUIRE(input.poll(std::chrono::milliseconds{100}, onKey));
+    REQUIRE(keys == std::vector<TerminalKey>{{KeyCode::UP}});
+  }
+
+  ::close(fds[1]);
+  REQUIRE_FALSE(input.poll(std::chrono::milliseconds{100}, onKey));
+  ::close(fds[0]);
+}
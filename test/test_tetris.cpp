@@ -1,5 +1,6 @@
 #include "ApprovalTests.hpp"
 #include "catch2/catch.hpp"
+#include <cstdlib>
 #include <functional>
 #include <ranges>
 #include <sstream>
@@ -64,6 +65,9 @@ std::string interleaveRows(const std::string &delimiter,
 
 // Handle basic inputs as handled by Tetris
 auto doInputs = []<int groupSize = 3>(auto &&...ts) {
+  // The standard factory draws from rand(), and a new game deals out several
+  // shapes at once, so reseed to get the same shapes whichever section runs
+  std::srand(1);
   auto tetris = TetrisFactory::standardTetris();
 
   std::vector<std::vector<std::string>> res;
@@ -162,7 +166,7 @@ TEST_CASE("TetrisHold") {
     struct IterateBlockFactory {
       mutable int i = 0;
       const Shape getShape() const {
-        return StandardShapeFactory::defaultShapes[i++];
+        return StandardShapeFactory::defaultShapes[i++ % 7];
       }
 
       const std::vector<const Shape> getShapes() const {
@@ -185,3 +189,83 @@ TEST_CASE("TetrisHold") {
         passStream);
   }
 }
+
+TEST_CASE("TetrisPreview") {
+  struct IterateBlockFactory {
+    mutable int i = 0;
+    const Shape getShape() const {
+      return StandardShapeFactory::defaultShapes[i++ % 7];
+    }
+
+    const std::vector<const Shape> getShapes() const {
+      return StandardShapeFactory::defaultShapes;
+    }
+  };
+  auto &shapes = StandardShapeFactory::defaultShapes;
+
+  SECTION("ShowsUpcomingShapes") {
+    auto tetris =
+        Tetris<IterateBlockFactory>::createTetris(16, 64, {}, 3).value();
+    REQUIRE(tetris.getPreviewSize() == 3);
+    REQUIRE(tetris.getPreview(0) == shapes[1]);
+    REQUIRE(tetris.getPreview(2) == shapes[3]);
+
+    // Hard drops and holds both take the next shape off the preview
+    tetris.handleInput(Key::SPACE);
+    REQUIRE(tetris.getPreview(0) == shapes[2]);
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(tetris.getPreview(0) == shapes[3]);
+
+    // Go through enough shapes for the preview to be topped up several times,
+    // spreading them out so they don't top out
+    for (int i = 0; i < 40; i++) {
+      for (int j = 0; j < i % 4 * 2; j++) {
+        tetris.handleInput(i % 2 ? Direction::LEFT : Direction::RIGHT);
+      }
+      tetris.handleInput(Key::SPACE);
+      REQUIRE_FALSE(tetris.isToppedOut());
+      REQUIRE(tetris.getPreview(0) == shapes[(4 + i) % 7]);
+      REQUIRE(tetris.getPreview(2) == shapes[(6 + i) % 7]);
+    }
+  }
+  SECTION("PreviewSizeLimits") {
+    using T = Tetris<IterateBlockFactory>;
+    REQUIRE(T::createTetris(10, 40, {}, 0).error() ==
+            T::InputError::INVALID_PREVIEW);
+    REQUIRE(T::createTetris(10, 40, {}, 15).error() ==
+            T::InputError::INVALID_PREVIEW);
+    REQUIRE(T::createTetris(10, 40, {}, 14).has_value());
+  }
+  SECTION("DealsOnlyWhatsNeeded") {
+    // Counts the shapes dealt by every copy of the factory
+    static int dealt;
+    struct CountingFactory {
+      const Shape getShape() const {
+        return StandardShapeFactory::defaultShapes[dealt++ % 7];
+      }
+
+      const std::vector<const Shape> getShapes() const {
+        return StandardShapeFactory::defaultShapes;
+      }
+    };
+
+    for (int previewSize : {1, 5, 14}) {
+      dealt = 0;
+      auto tetris =
+          Tetris<CountingFactory>::createTetris(16, 64, {}, previewSize)
+              .value();
+      // The shape in play and the preview
+      REQUIRE(dealt == previewSize + 1);
+
+      // Then nothing until the preview runs short, when a whole bag is dealt
+      tetris.handleInput(Key::HOLD);
+      REQUIRE(dealt == previewSize + 1 + 7);
+      for (int i = 0; i < 6; i++) {
+        tetris.handleInput(Key::SPACE);
+      }
+      REQUIRE(dealt == previewSize + 1 + 7);
+      tetris.handleInput(Key::SPACE);
+      REQUIRE(dealt == previewSize + 1 + 14);
+    }
+  }
+}
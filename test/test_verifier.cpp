@@ -0,0 +1,53 @@
+#include "catch2/catch.hpp"
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "../fixtures/replay_fixtures.hpp"
+#include "../lib/verifier.hpp"
+
+TEST_CASE("VerifyArchive") {
+  TempFile file{"test_verifier.tarc"};
+  constexpr std::size_t GAMES = 40;
+  std::vector<ArchivedResult> actual;
+  {
+    std::ofstream out{file.path, std::ios::binary};
+    ArchiveWriter<BagShapeFactory> writer{out, 32};
+    // Just to find out how each game really ended up
+    std::ostringstream scratchOut;
+    ArchiveWriter<BagShapeFactory> scratch{scratchOut, 32};
+    for (std::uint64_t seed = 1; seed <= GAMES; seed++) {
+      auto replay = recordGame(seed, 50 + 20 * (int)seed);
+      auto result = scratch.addGame(replay).value();
+      actual.push_back(result);
+
+      // Every seventh player claims a line they never cleared, and every
+      // eleventh a different final board
+      auto claimed = result;
+      if (seed % 7 == 0) {
+        claimed.lines++;
+      } else if (seed % 11 == 0) {
+        claimed.hash ^= 1;
+      }
+      REQUIRE(writer.addGame(replay, claimed).value() == result);
+    }
+  }
+
+  auto archive = ReplayArchive<BagShapeFactory>::open(file.path).value();
+  WorkStealingPool pool{4};
+  auto report = verifyArchive(pool, archive);
+  REQUIRE(report.verified == GAMES);
+  REQUIRE_FALSE(report.ok());
+
+  std::vector<std::size_t> flagged;
+  for (auto &mismatch : report.mismatches) {
+    flagged.push_back(mismatch.game);
+    REQUIRE_FALSE(mismatch.error);
+    REQUIRE(mismatch.actual == actual[mismatch.game]);
+    REQUIRE(mismatch.claimed != mismatch.actual);
+    // Only the claim is wrong, so the game didn't go wrong until the end
+    REQUIRE(mismatch.frame == mismatch.actual.lastFrame);
+  }
+  // Games are numbered from 0 but seeded from 1
+  REQUIRE(flagged == std::vector<std::size_t>{6, 10, 13, 20, 21, 27, 32, 34});
+}
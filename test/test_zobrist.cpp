@@ -0,0 +1,98 @@
+#include "catch2/catch.hpp"
+#include <vector>
+
+#include "../lib/tetris.hpp"
+
+namespace {
+// The hash of a board built up from scratch with the same cells
+std::uint64_t freshHash(const Board &board) {
+  Board fresh{board.getWidth(), board.getHeight()};
+  for (int y = 0; y < board.getHeight(); y++) {
+    for (int x = 0; x < board.getWidth(); x++) {
+      if (board.cellAt(x, y)) {
+        fresh.setCellAt(x, y, true);
+      }
+    }
+  }
+  return fresh.hash();
+}
+} // namespace
+
+TEST_CASE("BoardHash") {
+  Board board{10, 40};
+  REQUIRE(board.hash() == 0);
+
+  SECTION("SetCellAt") {
+    board.setCellAt(3, 4, true);
+    auto once = board.hash();
+    REQUIRE(once != 0);
+    board.setCellAt(3, 4, true);
+    REQUIRE(board.hash() == once);
+    board.setCellAt(3, 4, false);
+    REQUIRE(board.hash() == 0);
+  }
+  SECTION("PlaceAndClear") {
+    Xoshiro256 rng{99};
+    auto &shapes = StandardShapeFactory::defaultShapes;
+    for (int i = 0; i < 500; i++) {
+      auto shape = shapes[rng.below((std::uint32_t)shapes.size())];
+      shape.rotationIndex = (int)rng.below(4);
+      int x = (int)rng.below(board.getWidth() - shape.size + 1);
+      int y = 20;
+      if (board.collides(shape.mask(), x, y)) {
+        board = Board{10, 40};
+        continue;
+      }
+      y -= board.dropDistance(shape.mask(), x, y);
+      board.place(shape.mask(), x, y);
+      board.clearRows(y, shape.size);
+      REQUIRE(board.hash() == freshHash(board));
+    }
+  }
+}
+
+TEST_CASE("TetrisHash") {
+  auto tetris = TetrisFactory::seededTetris(5);
+  auto start = tetris.hash();
+
+  SECTION("MovingBackRestoresTheHash") {
+    tetris.handleInput(Direction::LEFT);
+    REQUIRE(tetris.hash() != start);
+    tetris.handleInput(Direction::RIGHT);
+    REQUIRE(tetris.hash() == start);
+
+    tetris.handleInput(Rotation::CLOCKWISE);
+    REQUIRE(tetris.hash() != start);
+    tetris.handleInput(Rotation::COUNTER_CLOCKWISE);
+    REQUIRE(tetris.hash() == start);
+  }
+  SECTION("SameStateSameHash") {
+    auto other = TetrisFactory::seededTetris(5);
+    for (auto input : {Input{Direction::LEFT}, Input{Direction::DOWN},
+                       Input{Rotation::CLOCKWISE}}) {
+      tetris.handleInput(input);
+    }
+    for (auto input : {Input{Rotation::CLOCKWISE}, Input{Direction::DOWN},
+                       Input{Direction::LEFT}}) {
+      other.handleInput(input);
+    }
+    REQUIRE(tetris.getShapeLocation() == other.getShapeLocation());
+    REQUIRE(tetris.hash() == other.hash());
+  }
+  SECTION("Hold") {
+    tetris.handleInput(Key::HOLD);
+    auto held = tetris.hash();
+    REQUIRE(held != start);
+    // Holding again does nothing until the next shape
+    tetris.handleInput(Key::HOLD);
+    REQUIRE(tetris.hash() == held);
+  }
+  SECTION("Drops") {
+    for (int i = 0; i < 30; i++) {
+      tetris.handleInput(i % 2 ? Input{Direction::LEFT}
+                               : Input{Direction::RIGHT});
+      tetris.handleInput(Key::SPACE);
+      REQUIRE(tetris.getBoard().hash() == freshHash(tetris.getBoard()));
+    }
+  }
+}